@@ -29,6 +29,9 @@ namespace hpp {
   namespace constraints {
 
     /// Square distance between input configuration and reference configuration
+    ///
+    /// The difference, value and Jacobian are only computed over the joints
+    /// with non-zero weights.
     class HPP_CONSTRAINTS_DLLAPI ConfigurationConstraint : public DifferentiableFunction
     {
       public:
@@ -74,9 +77,28 @@ namespace hpp {
         std::ostream& print (std::ostream& o) const;
       private:
         typedef Eigen::Array <bool, Eigen::Dynamic, 1> EigenBoolVector_t;
+        /// Lie group of the goal space with non-zero weights. Vector spaces
+        /// are split into intervals of variables with non-zero weights.
+        struct Component {
+          /// Rank in LiegroupSpace::liegroupTypes
+          std::size_t rank;
+          size_type iq, nq, iv, nv;
+          bool vectorSpace;
+          /// Whether the weights are not zero. Always true in components_.
+          bool selected;
+        };
+
+        /// Compute the components with non-zero weights
+        void computeComponents ();
+        /// Compute goal - argument over the components with non-zero
+        /// weights. The other values of result are set to zero.
+        void difference (ConfigurationIn_t argument, vectorOut_t result)
+          const;
+
         DevicePtr_t robot_;
         LiegroupElement goal_;
         vector_t weights_;
+        std::vector<Component> components_;
     }; // class ComBetweenFeet
   } // namespace constraints
 } // namespace hpp
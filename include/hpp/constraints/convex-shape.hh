@@ -114,8 +114,13 @@ namespace hpp {
         /// As isInside but consider A as expressed in joint frame.
         inline bool isInsideLocal (const vector3_t& Ap) const {
           assert (shapeDimension_ > 2);
-          for (std::size_t i = 0; i < shapeDimension_; ++i) {
-            if (Ns_[i].dot (Ap-Pts_[i]) > 0) return false;
+          for (std::size_t b = 0; b < edges_.size (); ++b) {
+            const EdgeBlock& e (edges_[b]);
+            // Ns_[i].dot (Ap - Pts_[i]) for the edges of the block
+            const EdgeBlock::Values_t d
+              ((e.nx * (Ap[0] - e.px) + e.ny * (Ap[1] - e.py))
+               + e.nz * (Ap[2] - e.pz));
+            if ((d > 0).any ()) return false;
           }
           return true;
         }
@@ -129,13 +134,33 @@ namespace hpp {
           const value_type inf = std::numeric_limits<value_type>::infinity();
           value_type minPosDist = inf, maxNegDist = - inf;
           bool outside = false;
-          for (std::size_t i = 0; i < shapeDimension_; ++i) {
-            value_type d = dist (a - Pts_[i], Ls_[i], Us_[i], Ns_[i]);
-            if (d > 0) {
+          for (std::size_t b = 0; b < edges_.size (); ++b) {
+            const EdgeBlock& e (edges_[b]);
+            typedef EdgeBlock::Values_t Values_t;
+            // Signed distance between a and the edges of the block. With
+            // w = a - Pts_[i], c1 = Us_[i].w and c2 = Ls_[i], it is +-|w| if
+            // c1 <= 0, +-|w - c2 Us_[i]| if c2 <= c1 and Ns_[i].w otherwise,
+            // of the sign of Ns_[i].w.
+            const Values_t wx (a[0] - e.px), wy (a[1] - e.py),
+              wz (a[2] - e.pz);
+            const Values_t c1 ((e.ux * wx + e.uy * wy) + e.uz * wz);
+            const Values_t uw ((e.nx * wx + e.ny * wy) + e.nz * wz);
+            const Values_t ex (wx - e.l * e.ux), ey (wy - e.l * e.uy),
+              ez (wz - e.l * e.uz);
+            const Values_t wNorm (((wx * wx + wy * wy) + wz * wz).sqrt ()),
+              eNorm (((ex * ex + ey * ey) + ez * ez).sqrt ());
+            const Values_t sign ((uw > 0).select (Values_t::Ones (),
+                                                  - Values_t::Ones ()));
+            const Values_t d ((c1 <= 0).select
+                              (sign * wNorm,
+                               (e.l <= c1).select (sign * eNorm, uw)));
+            if ((d > 0).any ()) {
               outside = true;
-              if (d < minPosDist) minPosDist = d;
+              minPosDist = std::min (minPosDist,
+                                     (d > 0).select (d, inf).minCoeff ());
             }
-            if (d <= 0 && d > maxNegDist) maxNegDist = d;
+            maxNegDist = std::max (maxNegDist,
+                                   (d <= 0).select (d, - inf).maxCoeff ());
           }
           if (outside) return minPosDist;
           return maxNegDist;
@@ -172,22 +197,47 @@ namespace hpp {
         Transform3f MinJoint_;
         JointPtr_t joint_;
 
+        /// Number of edges processed at once by isInsideLocal and
+        /// distanceLocal.
+        static const int EdgeBlockSize = 16;
+
       private:
-        /// Return the distance between the point A and the segment
-        /// [P, c2*v] oriented by u.
-        /// w = PA.
-        inline value_type dist (const vector3_t& w, const value_type& c2, const vector3_t& v, const vector3_t& u) const {
-          value_type c1;
-          c1 = v.dot (w);
-          if (c1 <= 0)
-            return (u.dot (w) > 0)?(w.norm()):(- w.norm());
-          if (c2 <= c1)
-            // TODO: (w - c2 * v).norm() == sqrt((u.dot(w)**2 + (c1 - c2)**2)
-            // second should be cheaper.
-            return (u.dot (w) > 0)?((w-c2*v).norm()):(-(w-c2*v).norm());
-          return u.dot (w);
+        /// Edges stored coordinate by coordinate (structure of arrays), in
+        /// blocks of fixed capacity. The last block is filled with copies of
+        /// the last edge, which change neither the containment test nor the
+        /// distance.
+        struct EdgeBlock
+        {
+          EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+          typedef Eigen::Array <value_type, EdgeBlockSize, 1> Values_t;
+          /// Pts_[i], Ns_[i], Us_[i] and Ls_[i]
+          Values_t px, py, pz, nx, ny, nz, ux, uy, uz, l;
+        }; // struct EdgeBlock
+        typedef std::vector <EdgeBlock, Eigen::aligned_allocator <EdgeBlock> >
+          EdgeBlocks_t;
+
+        /// Copy Pts_, Ns_, Us_ and Ls_ into edges_
+        void initEdgeBlocks ()
+        {
+          edges_.clear ();
+          const std::size_t nEdges (Ls_.size ());
+          if (nEdges == 0) return;
+          edges_.resize ((nEdges + EdgeBlockSize - 1) / EdgeBlockSize);
+          for (std::size_t b = 0; b < edges_.size (); ++b) {
+            EdgeBlock& e (edges_[b]);
+            for (std::size_t j = 0; j < (std::size_t) EdgeBlockSize; ++j) {
+              const std::size_t i (std::min (b * EdgeBlockSize + j,
+                                             nEdges - 1));
+              e.px[j] = Pts_[i][0]; e.py[j] = Pts_[i][1]; e.pz[j] = Pts_[i][2];
+              e.nx[j] = Ns_[i][0];  e.ny[j] = Ns_[i][1];  e.nz[j] = Ns_[i][2];
+              e.ux[j] = Us_[i][0];  e.uy[j] = Us_[i][1];  e.uz[j] = Us_[i][2];
+              e.l[j] = Ls_[i];
+            }
+          }
         }
 
+        EdgeBlocks_t edges_;
+
         static std::vector <vector3_t> triangleToPoints (const fcl::TriangleP& t) {
           // TODO
           // return points (t.a, t.b, t.c);
@@ -265,6 +315,7 @@ namespace hpp {
           MinJoint_.rotation().col(0) = N_;
           MinJoint_.rotation().col(1) = Ns_[0];
           MinJoint_.rotation().col(2) = Us_[0];
+          initEdgeBlocks ();
         }
     };
 
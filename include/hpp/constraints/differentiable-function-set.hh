@@ -74,6 +74,8 @@ namespace hpp {
           }
           functions_.push_back(func);
           result_.push_back (LiegroupElement (func->outputSpace ()));
+          rows_.push_back (outputSpace_->nq ());
+          derivativeRows_.push_back (outputSpace_->nv ());
           *outputSpace_ *= func->outputSpace ();
         }
 
@@ -88,47 +90,57 @@ namespace hpp {
 
         /// \}
 
+        /// Set whether the functions are evaluated in parallel
+        ///
+        /// If enabled and the global TaskScheduler has several workers, the
+        /// values and Jacobians of the functions are computed in parallel.
+        /// The results do not depend on the number of workers.
+        /// \note the functions must be thread safe, see TaskScheduler.
+        void parallelEvaluation (bool enable)
+        {
+          parallelEvaluation_ = enable;
+        }
+
+        /// Get whether the functions are evaluated in parallel
+        bool parallelEvaluation () const
+        {
+          return parallelEvaluation_;
+        }
+
         std::ostream& print (std::ostream& os) const;
 
         /// Constructor
         ///
         /// \param name the name of the constraints,
         DifferentiableFunctionSet (const std::string& name)
-          : DifferentiableFunction (0, 0, 0, name)
+          : DifferentiableFunction (0, 0, 0, name),
+            parallelEvaluation_ (false)
         {}
 
         DifferentiableFunctionSet ()
-          : DifferentiableFunction (0, 0, 0, "Stack")
+          : DifferentiableFunction (0, 0, 0, "Stack"),
+            parallelEvaluation_ (false)
         {}
 
       protected:
         void impl_compute (LiegroupElementRef result, ConfigurationIn_t arg)
-          const
-        {
-          size_type row = 0;
-          std::size_t i = 0;
-          for (Functions_t::const_iterator _f = functions_.begin();
-              _f != functions_.end(); ++_f) {
-            const DifferentiableFunction& f = **_f;
-            f.impl_compute(result_ [i], arg);
-            result.vector ().segment(row, f.outputSize()) =
-              result_ [i].vector ();
-            row += f.outputSize(); ++i;
-          }
-        }
-        void impl_jacobian (matrixOut_t jacobian, ConfigurationIn_t arg) const
-        {
-          size_type row = 0;
-          for (Functions_t::const_iterator _f = functions_.begin();
-              _f != functions_.end(); ++_f) {
-            const DifferentiableFunction& f = **_f;
-            f.impl_jacobian(jacobian.middleRows(row, f.outputDerivativeSize()), arg);
-            row += f.outputDerivativeSize();
-          }
-        }
+          const;
+        void impl_jacobian (matrixOut_t jacobian, ConfigurationIn_t arg) const;
       private:
+        struct ValueLoop;
+        struct JacobianLoop;
+        /// Compute the value of function i in its rows of result
+        void computeFunction (std::size_t i, vectorOut_t result,
+                              ConfigurationIn_t arg) const;
+        /// Compute the Jacobian of function i in its rows of jacobian
+        void computeFunctionJacobian (std::size_t i, matrixOut_t jacobian,
+                                      ConfigurationIn_t arg) const;
+
         Functions_t functions_;
         mutable std::vector <LiegroupElement> result_;
+        /// First row of each function in the value and in the Jacobian
+        std::vector <size_type> rows_, derivativeRows_;
+        bool parallelEvaluation_;
     }; // class DifferentiableFunctionSet
     /// \}
   } // namespace constraints
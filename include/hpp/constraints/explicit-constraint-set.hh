@@ -17,6 +17,7 @@
 #ifndef HPP_CONSTRAINTS_EXPLICIT_CONSTRAINT_SET_HH
 #define HPP_CONSTRAINTS_EXPLICIT_CONSTRAINT_SET_HH
 
+#include <map>
 #include <vector>
 
 #include <hpp/constraints/fwd.hh>
@@ -119,6 +120,12 @@ namespace hpp {
 	/// \param errorThreshold threshold to compare against the norms of
 	///        the constraint errors. Default value is accessible via
 	///        methods errorThreshold.
+        ///
+        /// Explicit constraints the input and output variables of which
+        /// have the values computed by the last call to solve are not
+        /// evaluated again: their error is set to zero. The right hand side
+        /// of a constraint should be modified through this set for this
+        /// to be valid.
         bool isSatisfied (vectorIn_t arg, value_type errorThreshold = -1) const;
 
         /// Whether input vector satisfies the constraints of the solver
@@ -127,6 +134,9 @@ namespace hpp {
 	/// \param errorThreshold threshold to compare against the norms of
 	///        the constraint errors. Default value is accessible via
 	///        methods errorThreshold.
+        ///
+        /// See isSatisfied (vectorIn_t, value_type) const about the
+        /// constraints solved by the last call to solve.
         bool isSatisfied (vectorIn_t arg, vectorOut_t error,
 			  value_type errorThreshold = -1) const;
 
@@ -176,8 +186,11 @@ namespace hpp {
           , derFunction_ (Eigen::VectorXi::Constant(space->nv (), -1))
           , errorThreshold_ (Eigen::NumTraits<value_type>::epsilon())
           , errorSize_(0)
+          , constantOutArgs_ (), constantOutValues_ ()
+          , constantOutValuesValid_ (false)
           // , Jg (nv, nv)
           , arg_ (space->nq ()), diff_(space->nv ()), diffSmall_()
+          , parallelEvaluation_ (false)
         {
           notOutArgs_.addRow(0, space->nq ());
           notOutDers_.addCol(0, space->nv ());
@@ -204,6 +217,27 @@ namespace hpp {
           return errorThreshold_*errorThreshold_;
         }
 
+        /// Set whether independent explicit constraints are evaluated in
+        /// parallel
+        ///
+        /// If enabled and the global TaskScheduler has several workers,
+        /// solve computes the constraints that do not depend on each other
+        /// in parallel, and jacobian evaluates the Jacobians of the
+        /// functions in parallel. The results do not depend on the number
+        /// of workers.
+        /// \note the functions must be thread safe, see TaskScheduler.
+        void parallelEvaluation (bool enable)
+        {
+          parallelEvaluation_ = enable;
+        }
+
+        /// Get whether independent explicit constraints are evaluated in
+        /// parallel
+        bool parallelEvaluation () const
+        {
+          return parallelEvaluation_;
+        }
+
         /// \}
 
         /// \name Input and outputs
@@ -336,6 +370,27 @@ namespace hpp {
         */
         void jacobian(matrixOut_t jacobian, vectorIn_t q) const;
 
+        /// Compute the product of a matrix by the Jacobian of the explicit
+        /// constraint resolution
+        ///
+        /// \param q input configuration,
+        /// \param G matrix with nv columns,
+        /// \retval result the product \f$G_{out} J_e\f$ where
+        ///         \f$G_{out}\f$ is composed of the columns of G
+        ///         corresponding to output variables and \f$J_e\f$ is
+        ///         the Jacobian of output variables with respect to non
+        ///         output variables (see jacobianNotOutToOut). The size of
+        ///         result is G.rows () x notOutDers ().nbIndices ().
+        ///
+        /// The Jacobian of the resolution is not built: the rows of G are
+        /// propagated backward through the explicit constraints, in the
+        /// reverse of the computation order. This is cheaper than calling
+        /// jacobian when G has fewer rows than there are input variables.
+        ///
+        /// \warning it is assumed solve(q) has been called before.
+        void jacobianProduct (vectorIn_t q, matrixIn_t G, matrixOut_t result)
+          const;
+
         /// \name Right hand side accessors
         /// \{
 
@@ -447,6 +502,8 @@ namespace hpp {
 
       private:
         typedef std::vector<bool> Computed_t;
+        struct SolveLevel;
+        struct FunctionJacobians;
 
         /// Compute output variables with respect to input variables
         /// \param i index of explicit constraint,
@@ -469,7 +526,22 @@ namespace hpp {
         /// then,
         ///   Jout = E.jacobian * Jin
         void computeJacobian(const std::size_t& i, matrixOut_t J) const;
+        /// Compute the Jacobians of the functions of the non constant
+        /// explicit constraints at configuration q.
+        void computeFunctionJacobians (vectorIn_t q) const;
+        /// Compute the Jacobian of the function of explicit constraint i at
+        /// configuration q.
+        void computeFunctionJacobian (const std::size_t& i, vectorIn_t q)
+          const;
         void computeOrder(const std::size_t& iF, std::size_t& iOrder, Computed_t& computed);
+        /// Split the non constant explicit constraints into levels_.
+        void computeLevels ();
+        /// Compute the output values of the constant explicit constraints
+        /// and store them in constantOutValues_.
+        void computeConstantOutValues () const;
+        /// Whether the input and output variables of explicit constraint i
+        /// in arg have the values computed by the last call to solve.
+        bool isSolved (const std::size_t& i, vectorIn_t arg) const;
 
         LiegroupSpacePtr_t configSpace_;
 
@@ -485,6 +557,12 @@ namespace hpp {
           mutable LiegroupElement f_value, res_qout;
           // jacobian of f
           mutable matrix_t jacobian;
+          // whether the explicit constraint has no input variable
+          bool constant;
+          // input and output values computed by the last call to solve,
+          // valid if solved is true.
+          mutable vector_t solvedQin, solvedQout;
+          mutable bool solved;
         }; // struct Data
 
         RowBlockIndices inArgs_, notOutArgs_;
@@ -495,7 +573,15 @@ namespace hpp {
         Eigen::MatrixXi inOutDependencies_;
 
         std::vector<Data> data_;
+        /// Index in data_ of the first constraint of each function
+        std::map<DifferentiableFunctionPtr_t, std::size_t> functionIndex_;
         std::vector<std::size_t> computationOrder_;
+        /// computationOrder_ without the constant explicit constraints.
+        std::vector<std::size_t> nonConstantOrder_;
+        /// Non constant explicit constraints sorted by level. The inputs
+        /// of the constraints of a level are computed by constraints of
+        /// lower levels, so that the constraints of a level are independent.
+        std::vector<std::vector<std::size_t> > levels_;
         /// For each configuration variable i, argFunction_[i] is the index in
         /// data_ of the function that computes this configuration
         /// variable.
@@ -504,8 +590,19 @@ namespace hpp {
         Eigen::VectorXi argFunction_, derFunction_;
         value_type errorThreshold_;
         size_type errorSize_;
+        /// Constant explicit constraints (without input variables, like
+        /// LockedJoint) are solved together: their output values are
+        /// stacked in constantOutValues_ and copied to the output
+        /// configuration variables constantOutArgs_ in one operation. The
+        /// values are recomputed when the right hand side changes.
+        RowBlockIndices constantOutArgs_;
+        mutable vector_t constantOutValues_;
+        mutable bool constantOutValuesValid_;
         // mutable matrix_t Jg;
         mutable vector_t arg_, diff_, diffSmall_;
+        /// Work matrices of jacobian and jacobianProduct
+        mutable matrix_t jacobianIn_, adjoint_, adjointOut_, adjointIn_;
+        bool parallelEvaluation_;
 
         /// Constructor for serialization
         ExplicitConstraintSet() 
@@ -514,6 +611,9 @@ namespace hpp {
           , outArgs_ (),  outDers_ ()
           , errorThreshold_ (Eigen::NumTraits<value_type>::epsilon())
           , errorSize_(0)
+          , constantOutArgs_ (), constantOutValues_ ()
+          , constantOutValuesValid_ (false)
+          , parallelEvaluation_ (false)
         {}
         /// Initialization for serialization
         void init(const LiegroupSpacePtr_t& space)
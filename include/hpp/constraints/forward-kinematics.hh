@@ -0,0 +1,91 @@
+// Copyright (c) 2026, CNRS
+//
+// This file is part of hpp-constraints.
+// hpp-constraints is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-constraints is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-constraints. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_CONSTRAINTS_FORWARD_KINEMATICS_HH
+#define HPP_CONSTRAINTS_FORWARD_KINEMATICS_HH
+
+#include <hpp/pinocchio/device-sync.hh>
+
+#include <hpp/constraints/fwd.hh>
+#include <hpp/constraints/config.hh>
+
+namespace hpp {
+  namespace constraints {
+    /// Compute the forward kinematics of a robot at its current configuration
+    ///
+    /// Inside a PartialKinematics scope, only the joints the velocity of
+    /// which is selected by the scope and their ancestors are updated: their
+    /// placements and, if the robot computes Jacobians, their columns of the
+    /// Jacobian. The other joints keep the values of a previous computation.
+    ///
+    /// The computation is also incremental: the configuration is compared
+    /// to the one of the previous call on the same data, and only the
+    /// joints the configuration of which, or of one of their ancestors,
+    /// changed are updated. Placements written by other means since then,
+    /// for instance by device.computeForwardKinematics (), are detected and
+    /// recomputed.
+    ///
+    /// Outside such a scope, or if the robot computes its center of mass,
+    /// this is device.computeForwardKinematics ().
+    ///
+    /// Frames and geometry placements are not updated. After a restricted
+    /// computation, the device is marked as not up to date, so that the
+    /// next call to its methods computeForwardKinematics,
+    /// computeFramesForwardKinematics or updateGeometryPlacements computes
+    /// the whole kinematics again.
+    ///
+    /// Only the functions that evaluate the kinematics through this method
+    /// benefit from the restriction (GenericTransformation and
+    /// ConvexShapeContact). They must only read the joints selected by
+    /// their active derivative parameters: a mask built from incomplete
+    /// active derivative parameters leaves the joints they read out of
+    /// date. The other functions compute the whole kinematics.
+    void HPP_CONSTRAINTS_DLLAPI computeForwardKinematics
+    (pinocchio::DeviceSync& device);
+
+    /// Number of joints updated by the last call to computeForwardKinematics
+    /// of the calling thread
+    ///
+    /// Outside a PartialKinematics scope, all the joints are updated.
+    size_type HPP_CONSTRAINTS_DLLAPI updatedJoints ();
+
+    /// Restrict computeForwardKinematics to a subset of the joints
+    ///
+    /// The restriction applies to the calling thread for the lifetime of the
+    /// object. Scopes can be nested, the innermost one applies.
+    class HPP_CONSTRAINTS_DLLAPI PartialKinematics
+    {
+    public:
+      /// Constructor
+      /// \param velocityMask velocity variables the joints of which are
+      ///        updated, for instance the active derivative parameters of
+      ///        the functions to evaluate. It must outlive the object. If its
+      ///        size differs from the number of degrees of freedom of the
+      ///        robot, including the extra configuration space, the whole
+      ///        kinematics is computed.
+      explicit PartialKinematics (const ArrayXb& velocityMask);
+
+      ~PartialKinematics ();
+
+    private:
+      PartialKinematics (const PartialKinematics&);
+      PartialKinematics& operator= (const PartialKinematics&);
+
+      const ArrayXb* previous_;
+    }; // class PartialKinematics
+  } // namespace constraints
+} // namespace hpp
+
+#endif // HPP_CONSTRAINTS_FORWARD_KINEMATICS_HH
@@ -0,0 +1,176 @@
+// Copyright (c) 2026, CNRS
+//
+// This file is part of hpp-constraints.
+// hpp-constraints is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-constraints is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-constraints. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_CONSTRAINTS_FUNCTION_AUTO_DIFF_HH
+# define HPP_CONSTRAINTS_FUNCTION_AUTO_DIFF_HH
+
+# include <vector>
+# include <stdexcept>
+
+# include <unsupported/Eigen/AutoDiff>
+
+# include <pinocchio/algorithm/joint-configuration.hpp>
+
+# include <hpp/pinocchio/device.hh>
+# include <hpp/pinocchio/liegroup-space.hh>
+
+# include <hpp/constraints/differentiable-function.hh>
+
+namespace hpp {
+  namespace constraints {
+    namespace function {
+      /// Differentiable function the Jacobian of which is computed by
+      /// forward mode automatic differentiation
+      ///
+      /// \tparam Derived the child class. It implements the function once,
+      ///         as a template over the scalar type:
+      /// \code
+      /// template <typename Scalar> void compute
+      ///   (Eigen::Matrix<Scalar, Eigen::Dynamic, 1>& result,
+      ///    const Eigen::Matrix<Scalar, Eigen::Dynamic, 1>& argument) const;
+      /// \endcode
+      /// This method is called with Scalar = value_type to evaluate the
+      /// function and with Scalar = AutoDiff::ADScalar_t to compute the
+      /// Jacobian. It should be accessible from this class (public, or
+      /// AutoDiff declared as friend).
+      ///
+      /// Only the velocity parameters flagged in
+      /// activeDerivativeParameters are seeded: the cost of the Jacobian
+      /// is proportional to their number. The output space is a vector
+      /// space.
+      ///
+      /// If a robot is given, the input is a configuration of the robot
+      /// and the Jacobian is expressed with respect to the velocity, as
+      /// for finiteDifferenceCentral: the input is seeded with the
+      /// derivative of \f$\mathbf{v}\mapsto\mathbf{q}\oplus\mathbf{v}\f$
+      /// at \f$\mathbf{v}=0\f$. Otherwise, the input space is
+      /// considered a vector space.
+      template <typename Derived>
+      class AutoDiff : public DifferentiableFunction
+      {
+      public:
+        /// Scalar type used to compute the Jacobian
+        typedef Eigen::AutoDiffScalar<vector_t> ADScalar_t;
+        /// Vector of ADScalar_t
+        typedef Eigen::Matrix<ADScalar_t, Eigen::Dynamic, 1> ADVector_t;
+
+        virtual ~AutoDiff () {}
+
+        /// Get the robot used to integrate velocities, if any
+        const DevicePtr_t& robot () const
+        {
+          return robot_;
+        }
+
+      protected:
+        /// Constructor
+        /// \param sizeInput dimension of the function input,
+        /// \param sizeInputDerivative dimension of the function input
+        ///        derivative,
+        /// \param sizeOutput dimension of the output,
+        /// \param name function name,
+        /// \param robot if not empty, the input is a configuration of this
+        ///        robot.
+        AutoDiff (size_type sizeInput, size_type sizeInputDerivative,
+                  size_type sizeOutput, std::string name = std::string (),
+                  const DevicePtr_t& robot = DevicePtr_t ()) :
+          DifferentiableFunction (sizeInput, sizeInputDerivative,
+                                  LiegroupSpace::Rn (sizeOutput), name),
+          robot_ (robot)
+        {
+          if (robot_) {
+            if (robot_->configSize () != sizeInput ||
+                robot_->numberDof () != sizeInputDerivative)
+              throw std::invalid_argument ("Input sizes of function "
+                  + name + " do not match the configuration space of robot "
+                  + robot_->name () + ".");
+          } else if (sizeInput != sizeInputDerivative) {
+            throw std::invalid_argument ("Function " + name + " without "
+                "robot should have input and input derivative of same size.");
+          }
+        }
+
+        void impl_compute (LiegroupElementRef result, vectorIn_t argument)
+          const
+        {
+          const vector_t x (argument);
+          vector_t y (outputSize ());
+          derived ().compute (y, x);
+          result.vector () = y;
+        }
+
+        void impl_jacobian (matrixOut_t jacobian, vectorIn_t arg) const
+        {
+          const ArrayXb& adp (activeDerivativeParameters_);
+          std::vector<size_type> cols;
+          for (size_type j = 0; j < inputDerivativeSize_; ++j)
+            if (adp[j]) cols.push_back (j);
+          const size_type n ((size_type) cols.size ());
+
+          // Seed the input
+          ADVector_t x (inputSize_);
+          for (size_type i = 0; i < inputSize_; ++i) {
+            x[i].value () = arg[i];
+            x[i].derivatives ().setZero (n);
+          }
+          if (robot_) {
+            const matrix_t dq (integrationJacobian (arg));
+            for (size_type i = 0; i < inputSize_; ++i)
+              for (size_type k = 0; k < n; ++k)
+                x[i].derivatives () [k] = dq (i, cols[k]);
+          } else {
+            for (size_type k = 0; k < n; ++k)
+              x[cols[k]].derivatives () [k] = 1;
+          }
+
+          ADVector_t y (outputSize ());
+          derived ().compute (y, x);
+
+          jacobian.setZero ();
+          for (size_type r = 0; r < outputDerivativeSize (); ++r) {
+            // Outputs that do not depend on the input have empty
+            // derivatives.
+            if (y[r].derivatives ().size () != n) continue;
+            for (size_type k = 0; k < n; ++k)
+              jacobian (r, cols[k]) = y[r].derivatives () [k];
+          }
+        }
+
+      private:
+        const Derived& derived () const
+        {
+          return static_cast <const Derived&> (*this);
+        }
+
+        /// Derivative of the configuration with respect to the velocity
+        matrix_t integrationJacobian (vectorIn_t arg) const
+        {
+          const pinocchio::Model& model (robot_->model ());
+          matrix_t dq (matrix_t::Zero (inputSize_, inputDerivativeSize_));
+          ::pinocchio::integrateCoeffWiseJacobian
+              (model, arg.head (model.nq),
+               dq.topLeftCorner (model.nq, model.nv));
+          // Extra configuration space is a vector space.
+          dq.bottomRightCorner (inputSize_ - model.nq,
+                                inputDerivativeSize_ - model.nv).setIdentity ();
+          return dq;
+        }
+
+        DevicePtr_t robot_;
+      }; // class AutoDiff
+    } // namespace function
+  } // namespace constraints
+} // namespace hpp
+#endif // HPP_CONSTRAINTS_FUNCTION_AUTO_DIFF_HH
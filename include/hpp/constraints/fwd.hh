@@ -183,6 +183,8 @@ namespace hpp {
     namespace solver {
       class HierarchicalIterative;
       class BySubstitution;
+      class Recorder;
+      typedef shared_ptr <Recorder> RecorderPtr_t;
     } // namespace solver
 
     namespace explicit_ {
@@ -280,6 +280,10 @@ namespace hpp {
       inline const Transform3f& frame2InJoint2 () const {
 	return m_.F2inJ2;
       }
+      /// Get robot
+      inline const DevicePtr_t& robot () const {
+	return robot_;
+      }
 
       virtual std::ostream& print (std::ostream& o) const;
 
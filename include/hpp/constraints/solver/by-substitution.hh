@@ -17,6 +17,8 @@
 #ifndef HPP_CONSTRAINTS_SOLVER_BY_SUBSTITUTION_HH
 #define HPP_CONSTRAINTS_SOLVER_BY_SUBSTITUTION_HH
 
+#include <algorithm>
+#include <stdexcept>
 #include <vector>
 
 #include <hpp/constraints/fwd.hh>
@@ -25,6 +27,7 @@
 #include <hpp/constraints/locked-joint.hh>
 #include <hpp/constraints/explicit-constraint-set.hh>
 #include <hpp/constraints/solver/hierarchical-iterative.hh>
+#include <hpp/constraints/solver/recorder.hh>
 
 namespace hpp {
   namespace constraints {
@@ -73,9 +76,45 @@ namespace hpp {
         /// If the constraint is explicit and compatible with previously
         /// inserted constraints, it is added as explicit. Otherwise, it is
         /// added as implicit.
+        ///
+        /// If automatic promotion is enabled, an implicit constraint that
+        /// has an equivalent explicit form is added as explicit if
+        /// compatible with previously inserted constraints.
+        /// \sa automaticPromotion
         bool add (const ImplicitPtr_t& numericalConstraint,
                   const std::size_t& priority = 0);
 
+        /// Add a set of constraints
+        ///
+        /// The constraints added as explicit are selected by explicitSplit
+        /// and added first, so that the result does not depend on the order
+        /// of the constraints in the set. The other constraints are added as
+        /// implicit with the given priority.
+        /// \return the number of constraints added, that is the size of
+        ///         the set minus the constraints already in the solver.
+        std::size_t add (const NumericalConstraints_t& numericalConstraints,
+                         const std::size_t& priority = 0);
+
+        /// Select the constraints of a set to add as explicit
+        ///
+        /// Among the explicit constraints of the set and, if automatic
+        /// promotion is enabled, the implicit constraints that have an
+        /// explicit form, select the constraints that eliminate the largest
+        /// number of variables, given the explicit constraints already in
+        /// the solver. Selected constraints have disjoint outputs and their
+        /// dependencies do not form a cycle.
+        ///
+        /// The selection is optimal for up to
+        /// maxExactExplicitSplitCandidates candidates. Above, the candidates
+        /// are selected greedily by decreasing output dimension.
+        /// \return for each constraint of the set, whether it is selected.
+        std::vector <bool> explicitSplit
+        (const NumericalConstraints_t& numericalConstraints) const;
+
+        /// Maximal number of candidates for which explicitSplit computes an
+        /// optimal selection
+        static const std::size_t maxExactExplicitSplitCandidates = 16;
+
         /// \deprecated use add(const ImplicitPtr_t&, const std::size_t)
         bool add (const ImplicitPtr_t& numericalConstraint,
                   const segments_t& passiveDofs,
@@ -106,6 +145,110 @@ namespace hpp {
           return explicit_;
         }
 
+        /// Enable or disable automatic promotion of implicit constraints
+        ///
+        /// When enabled, method add detects implicit constraints that can
+        /// be expressed in explicit form and substitutes the equivalent
+        /// explicit constraint. Currently, the constraints detected are
+        /// TransformationR3xSO3 and RelativeTransformationR3xSO3 with
+        /// \li joint 2 with configuration space SE(3) or R3xSO3,
+        /// \li joint 2 not an ancestor of joint 1,
+        /// \li all rows active and comparison types Equality or
+        ///     EqualToZero.
+        /// They are replaced by an instance of explicit_::RelativePose.
+        ///
+        /// The constraint passed to method add remains the one used to
+        /// access the right hand side and to test satisfaction.
+        /// \note Only constraints added after the call are affected.
+        void automaticPromotion (bool enable)
+        {
+          promote_ = enable;
+        }
+
+        /// Whether automatic promotion of implicit constraints is enabled
+        bool automaticPromotion () const
+        {
+          return promote_;
+        }
+
+        /// Counters of the solution cache
+        /// \sa solutionCache
+        struct SolutionCacheStatistics
+        {
+          /// Number of solves answered by a cached configuration
+          size_type hits;
+          /// Number of solves started from a cached configuration
+          size_type warmStarts;
+          /// Number of solves without usable cached configuration
+          size_type misses;
+          /// Number of iterations performed by solves using the cache
+          size_type iterations;
+          /// Estimate of the number of iterations saved by the cache
+          ///
+          /// For each hit or warm start, number of iterations that were
+          /// needed to compute the cached solution minus the number of
+          /// iterations actually performed.
+          size_type savedIterations;
+
+          SolutionCacheStatistics () : hits (0), warmStarts (0), misses (0),
+            iterations (0), savedIterations (0)
+          {}
+        };
+
+        /// Enable or disable the solution cache
+        ///
+        /// \param size maximal number of cached solutions. 0 disables the
+        ///        cache,
+        /// \param radius maximal distance (infinity norm in the ambient
+        ///        space) between the input configuration and a cached
+        ///        solution for the latter to be used,
+        /// \param rhsRadius maximal distance (infinity norm) between the
+        ///        current right hand side and the right hand side of a
+        ///        cached solution. Right hand sides closer than the error
+        ///        threshold are always considered equal.
+        ///
+        /// When the cache is enabled, method solve (without optimization)
+        /// first looks for the closest cached solution. If this solution
+        /// satisfies the constraints, it is returned without iterating.
+        /// Otherwise, the resolution starts from the cached solution and
+        /// falls back to the input configuration upon failure. Converged
+        /// solutions are stored, the oldest ones being discarded.
+        ///
+        /// \note the cached solution returned may differ from the input
+        ///       configuration by up to radius: use a small radius when
+        ///       the result of the projection is required to be close to
+        ///       the input.
+        /// \note the cache is cleared when constraints are added.
+        void solutionCache (std::size_t size, value_type radius,
+                            value_type rhsRadius = 0);
+
+        /// Maximal number of cached solutions
+        std::size_t solutionCacheSize () const
+        {
+          return cacheSize_;
+        }
+
+        /// Remove all the cached solutions
+        ///
+        /// Statistics are kept.
+        void clearSolutionCache () const
+        {
+          cache_.clear ();
+          cacheNext_ = 0;
+        }
+
+        /// Get the statistics of the solution cache
+        const SolutionCacheStatistics& solutionCacheStatistics () const
+        {
+          return cacheStats_;
+        }
+
+        /// Reset the statistics of the solution cache
+        void resetSolutionCacheStatistics ()
+        {
+          cacheStats_ = SolutionCacheStatistics ();
+        }
+
         /// Check whether a numerical constraint has been added
         /// \param numericalConstraint numerical constraint
         /// \return true if numerical constraint is already in the solver.
@@ -138,7 +281,11 @@ namespace hpp {
           // explicit_.solve(arg);
           // iterative_.solve(arg, ls);
           // } else {
-          return impl_solve (arg, optimize, ls);
+          if (!recorder_) return dispatchSolve (arg, optimize, ls);
+          recorder_->start (*this, arg, ls, optimize);
+          Status status (dispatchSolve (arg, optimize, ls));
+          recorder_->stop (*this, arg, status);
+          return status;
           // }
         }
 
@@ -168,6 +315,75 @@ namespace hpp {
                                       ConfigurationIn_t to,
                                       ConfigurationOut_t result);
 
+        /// Compute the tangent space at a configuration
+        ///
+        /// \param arg configuration.
+        ///
+        /// The transposed reduced Jacobian is decomposed by a column-pivoting
+        /// QR decomposition, and only the orthonormal basis \f$B\f$ of its
+        /// row space (thin factor, of size number of free variables x rank)
+        /// is kept until the next call. Successive projections by
+        /// projectVectorOnTangentSpace then cost two matrix-vector products.
+        void computeTangentSpace (vectorIn_t arg) const;
+
+        /// Project a velocity on the tangent space computed by
+        /// computeTangentSpace
+        ///
+        /// \param velocity velocity to project,
+        /// \retval result the projected velocity
+        ///         \f$(I - BB^T)\f$ velocity. Only free variables are
+        ///         written, as in projectVectorOnKernel.
+        /// \pre computeTangentSpace has been called.
+        void projectVectorOnTangentSpace (vectorIn_t velocity,
+                                          vectorOut_t result) const;
+
+        /// Compute an orthonormal basis of the tangent space at a configuration
+        ///
+        /// \param arg configuration,
+        /// \return a matrix of size nv x d the columns of which are an
+        ///         orthonormal basis of the kernel of the reduced Jacobian.
+        ///         Rows corresponding to variables that are not free are
+        ///         zero.
+        ///
+        /// The basis is made of the last columns of the orthogonal factor of
+        /// the decomposition of computeTangentSpace. Only these columns are
+        /// formed. The basis does not change the tangent space used by
+        /// projectVectorOnTangentSpace.
+        const matrix_t& tangentBasis (vectorIn_t arg) const;
+
+        /// Project a discretized path on the constraints
+        ///
+        /// \param path matrix the columns of which are the configurations
+        ///        of the path. The configurations are projected in place.
+        /// \param continuity weight \f$w\geq 0\f$ of the continuity term.
+        /// \return SUCCESS if all configurations satisfy the constraints,
+        ///         MAX_ITERATION_REACHED or INFEASIBLE otherwise.
+        ///
+        /// All configurations are projected jointly. At each iteration, the
+        /// steps \f$\mathbf{dq}_k\f$ of the \f$K\f$ configurations minimize
+        /// \f[
+        /// \sum_{k=0}^{K-1} \|\mathbf{dq}_k\|^2 + w \sum_{k=0}^{K-2}
+        /// \|\mathbf{q}_{k+1} - \mathbf{q}_k + \mathbf{dq}_{k+1} -
+        /// \mathbf{dq}_k\|^2
+        /// \f]
+        /// subject to the linearized constraints \f$J_k\mathbf{dq}_k =
+        /// -\mathbf{f}_k\f$. Steps are parameterized by the kernels of the
+        /// Jacobians, which yields a block-tridiagonal system solved in
+        /// linear time with respect to \f$K\f$. For \f$w=0\f$, each
+        /// configuration follows its own Gauss-Newton step.
+        ///
+        /// After each step, the explicit constraints are solved again for
+        /// every configuration. The iterations stop when all configurations
+        /// satisfy the implicit and explicit constraints.
+        ///
+        /// \note priority levels are merged, the last level being ignored if
+        ///       it is optional.
+        /// \note Unlike solve, the steps are not damped by a line search on
+        ///       the error: the step lengths follow the sequence of
+        ///       lineSearch::FixedSequence, whatever the error of the
+        ///       configurations.
+        Status solvePath (matrixOut_t path, value_type continuity = 0) const;
+
         inline Status solve (vectorOut_t arg) const
         {
           return solve(arg, DefaultLineSearch());
@@ -263,6 +479,21 @@ namespace hpp {
                                     vectorIn_t arg, vectorOut_t error,
                                     bool& constraintFound) const;
 
+        /// Whether a constraint is satisfied at the configuration returned
+        /// by the last call to solve
+        ///
+        /// Implicit constraints are read from the snapshot without being
+        /// evaluated. Explicit constraints are checked by the explicit
+        /// constraint set, that does not evaluate the constraints solved at
+        /// the snapshot configuration.
+        /// \throw std::logic_error if snapshot ().valid is false.
+        /// \note the snapshot is not valid if storeSnapshot is false, or
+        ///       when solve returns a cached solution or a configuration
+        ///       visited before the last evaluation of the constraints.
+        bool snapshotConstraintSatisfied (const ImplicitPtr_t& constraint,
+                                          vectorOut_t error,
+                                          bool& constraintFound) const;
+
       template <typename LineSearchType>
           bool oneStep (vectorOut_t arg, LineSearchType& lineSearch) const
         {
@@ -283,6 +514,7 @@ namespace hpp {
         {
           solver::HierarchicalIterative::errorThreshold(threshold);
           explicit_.errorThreshold(threshold);
+          clearSolutionCache ();
         }
         /// Get error threshold
         value_type errorThreshold () const
@@ -290,6 +522,24 @@ namespace hpp {
           return solver::HierarchicalIterative::errorThreshold();
         }
 
+        /// Set the tolerance of the optimization of the last level
+        ///
+        /// When solve is called with optimize set to true, the optimization
+        /// stops when a step decreases the squared norm of the error of the
+        /// last level by less than tolerance times its previous value.
+        void optimizationTolerance (const value_type& tolerance)
+        {
+          if (tolerance < 0)
+            throw std::invalid_argument ("The optimization tolerance must be "
+                                         "non-negative.");
+          optimizationTolerance_ = tolerance;
+        }
+        /// Get the tolerance of the optimization of the last level
+        value_type optimizationTolerance () const
+        {
+          return optimizationTolerance_;
+        }
+
         /// Return the indices in the input vector which are solved implicitely.
         ///
         /// The other dof which are modified are solved explicitely.
@@ -314,10 +564,98 @@ namespace hpp {
         template <typename LineSearchType>
           Status impl_solve (vectorOut_t arg, bool optimize, LineSearchType ls) const;
 
+        template <typename LineSearchType>
+          Status cachedSolve (vectorOut_t arg, LineSearchType ls) const;
+
+        /// Solve with or without the solution cache, without recording the
+        /// call
+        template <typename LineSearchType>
+          Status dispatchSolve (vectorOut_t arg, bool optimize,
+                                LineSearchType ls) const
+        {
+          if (cacheSize_ > 0 && !optimize)
+            return cachedSolve (arg, ls);
+          return impl_solve (arg, optimize, ls);
+        }
+
+        /// Solution stored in the solution cache
+        struct CachedSolution
+        {
+          vector_t rightHandSide;
+          vector_t config;
+          /// Number of iterations needed to compute config
+          size_type iterations;
+        };
+        typedef std::vector<CachedSolution> SolutionCache_t;
+
+        /// Get the cached solution closest to arg, compatible with rhs
+        /// \return the cached solution or NULL if none is close enough.
+        const CachedSolution* cachedSolution (vectorIn_t rhs, vectorIn_t arg)
+          const;
+
+        /// Store a converged solution in the cache
+        void cacheSolution (vectorIn_t rhs, vectorIn_t arg,
+                            size_type iterations) const;
+
+        /// Build the explicit form of an implicit constraint
+        /// \return the explicit constraint, or an empty pointer if the
+        ///         constraint cannot be promoted.
+        ExplicitPtr_t promoteToExplicit (const ImplicitPtr_t& constraint) const;
+
+        /// Get the explicit constraint stored in explicit_ for a constraint
+        /// \return the constraint itself if explicit, the explicit
+        ///         constraint it has been promoted to, or an empty pointer.
+        ExplicitPtr_t explicitForm (const ImplicitPtr_t& constraint) const;
+
+        /// Decompose the transposed reduced Jacobian at a configuration in
+        /// tangentQr_
+        /// \return the rank of the reduced Jacobian.
+        size_type decomposeTangentSpace (vectorIn_t arg) const;
+
+        /// Update the Jacobian of the problem with the product of the
+        /// active rows of the Jacobians of the levels by the Jacobian of the
+        /// explicit constraints, computed by
+        /// ExplicitConstraintSet::jacobianProduct.
+        /// \param nRows total number of active rows.
+        void updateJacobianByReverseAccumulation (vectorIn_t arg,
+                                                  size_type nRows) const;
+
+        typedef std::vector<std::pair<ImplicitPtr_t, ExplicitPtr_t> >
+          Promoted_t;
+
         ExplicitConstraintSet explicit_;
         mutable matrix_t Je_, JeExpanded_;
-
-        BySubstitution() {}
+        /// Active rows of the Jacobians of the levels and their product by
+        /// the Jacobian of the explicit constraints, used by
+        /// updateJacobianByReverseAccumulation
+        mutable matrix_t implicitJ_, implicitJe_;
+        bool promote_;
+        /// Implicit constraints added as explicit and their explicit form.
+        Promoted_t promoted_;
+        /// Solution cache
+        std::size_t cacheSize_;
+        value_type cacheRadius_, cacheRhsRadius_;
+        mutable SolutionCache_t cache_;
+        /// Index of the next cached solution to replace when the cache is full
+        mutable std::size_t cacheNext_;
+        mutable SolutionCacheStatistics cacheStats_;
+        /// Relative decrease of the cost below which the optimization stops
+        value_type optimizationTolerance_;
+        /// Decomposition of the transposed reduced Jacobian computed by
+        /// computeTangentSpace and tangentBasis
+        mutable Eigen::ColPivHouseholderQR <matrix_t> tangentQr_;
+        /// Orthonormal basis of the row space of the reduced Jacobian, in
+        /// free variables, computed by computeTangentSpace
+        mutable matrix_t rowSpaceBasis_;
+        /// Basis of the kernel of the reduced Jacobian expanded to the
+        /// tangent space
+        mutable matrix_t tangentBasis_;
+        /// Jacobian of a configuration and its decomposition in solvePath
+        mutable matrix_t pathJ_;
+        mutable SVD_t pathSvd_;
+
+        BySubstitution() : promote_ (false), cacheSize_ (0), cacheRadius_ (0),
+          cacheRhsRadius_ (0), cacheNext_ (0) {}
         HPP_SERIALIZABLE_SPLIT();
       }; // class BySubstitution
       /// \}
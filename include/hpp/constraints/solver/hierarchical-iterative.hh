@@ -59,6 +59,39 @@ namespace hpp {
           mutable vector_t arg_darg, df, darg;
         };
 
+        /// Backtracking line search with polynomial interpolation.
+        ///
+        /// Like Backtracking, a step \f$\alpha\f$ is accepted when
+        /// \f$\phi(\alpha) \le \phi(0) + c \alpha \phi'(0)\f$ where
+        /// \f$\phi(\alpha) = \|f(\mathbf{q} + \alpha \mathbf{u})\|^2\f$.
+        /// Instead of contracting the step by a constant factor, the next
+        /// trial step minimizes a quadratic interpolant of \f$\phi(0)\f$,
+        /// \f$\phi'(0)\f$ and the first rejected value, then a cubic
+        /// interpolant of the two last rejected values. The new step is
+        /// safeguarded in \f$[\sigma_{low} \alpha, \sigma_{high} \alpha]\f$.
+        ///
+        /// Trial steps only evaluate constraint values, the Jacobian is
+        /// computed by the solver at the accepted step.
+        struct Interpolation : Backtracking {
+          Interpolation ();
+
+          template <typename SolverType>
+          bool operator() (const SolverType& solver, vectorOut_t arg,
+                           vectorOut_t darg);
+
+          /// Compute the minimizer of the quadratic or cubic interpolant.
+          /// \param phi0, dphi0 value and derivative of \f$\phi\f$ at 0,
+          /// \param alpha, phiAlpha last rejected step and its value,
+          /// \param alphaPrev, phiPrev previous rejected step and its value,
+          ///        alphaPrev is negative if there is no previous step.
+          /// \return the next step, safeguarded.
+          value_type nextStep (value_type phi0, value_type dphi0,
+              value_type alpha, value_type phiAlpha,
+              value_type alphaPrev, value_type phiPrev) const;
+
+          value_type sigmaLow, sigmaHigh;
+        };
+
         /// The step size is computed using the recursion
         /// \f$ \alpha_{i+1} = \alpha - K \times (\alpha_{max} - \alpha_i) \f$
         /// where \f$K\f$ and \f$\alpha_{max}\f$ are some constant values.
@@ -112,6 +145,19 @@ namespace hpp {
           ///         saturated
           virtual bool saturate(vectorIn_t q, vectorOut_t qSat,
               Eigen::VectorXi& saturation);
+          /// Saturate only some configuration variables
+          ///
+          /// \param q a configuration,
+          /// \param intervals sorted intervals of configuration variables,
+          /// \retval qSat, saturation same as saturate for the
+          ///         configuration variables of the intervals. Other values
+          ///         are left unchanged.
+          /// \return true if and only if at least one degree of freedom of
+          ///         the intervals has been saturated.
+          ///
+          /// The default implementation calls saturate.
+          virtual bool saturateIntervals(vectorIn_t q, vectorOut_t qSat,
+              Eigen::VectorXi& saturation, const segments_t& intervals);
           virtual ~Base() {}
         };
         /// \brief saturation from a std::function.
@@ -129,6 +175,8 @@ namespace hpp {
         struct Bounds : Base {
           bool saturate(vectorIn_t q, vectorOut_t qSat,
               Eigen::VectorXi& saturation);
+          bool saturateIntervals(vectorIn_t q, vectorOut_t qSat,
+              Eigen::VectorXi& saturation, const segments_t& intervals);
           Bounds () {}
           Bounds (const vector_t& lb, const vector_t& ub) : lb(lb), ub(ub) {}
           vector_t lb, ub;
@@ -138,6 +186,8 @@ namespace hpp {
           /// \todo write a visitor.
           bool saturate(vectorIn_t q, vectorOut_t qSat,
               Eigen::VectorXi& saturation);
+          bool saturateIntervals(vectorIn_t q, vectorOut_t qSat,
+              Eigen::VectorXi& saturation, const segments_t& intervals);
           Device() {}
           Device(const DevicePtr_t& device) : device (device) {}
           DevicePtr_t device;
@@ -174,7 +224,8 @@ namespace hpp {
       /// \li \f$\alpha_i\f$ is a sequence of real numbers depending on the
       ///     line search strategy. Possible line-search strategies are
       ///     lineSearch::Constant, lineSearch::Backtracking,
-      ///     lineSearch::FixedSequence, lineSearch::ErrorNormBased.
+      ///     lineSearch::Interpolation, lineSearch::FixedSequence,
+      ///     lineSearch::ErrorNormBased.
       /// until
       /// \li the residual \f$\|f(\mathbf{q})\|\f$ is below an error threshold, or
       /// \li the maximal number of iterations has been reached.
@@ -352,10 +403,87 @@ namespace hpp {
                                     vectorIn_t arg, vectorOut_t error,
                                     bool& constraintFound) const;
 
+        /// Errors of the constraints at the configuration returned by the
+        /// last call to solve
+        ///
+        /// If storeSnapshot is true, the snapshot is filled by solve from
+        /// the last evaluation of the constraints, without evaluating them
+        /// again. It is valid until the next call to solve.
+        struct Snapshot {
+          /// \cond
+          EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+          /// \endcond
+          /// Whether the constraints were evaluated at config. If false,
+          /// the other fields are meaningless.
+          bool valid;
+          /// Configuration returned by solve
+          vector_t config;
+          /// Errors of the implicit constraints, as computed by
+          /// residualError
+          vector_t error;
+          /// Maximal squared norm of the errors of the constraints. The
+          /// last level is ignored if it is optional.
+          value_type squaredNorm;
+          /// Jacobian of the implicit constraints, as computed by
+          /// getJacobian. Empty unless snapshotJacobian is true.
+          matrix_t jacobian;
+        };
+
+        /// Get the errors of the constraints at the configuration returned
+        /// by the last call to solve
+        const Snapshot& snapshot () const
+        {
+          return snapshot_;
+        }
+
+        /// Whether a constraint is satisfied at the configuration returned
+        /// by the last call to solve
+        ///
+        /// Same as isConstraintSatisfied (constraint, snapshot ().config,
+        /// error, constraintFound) without evaluating the constraint.
+        /// \note error is the error after application of the comparison
+        ///       types.
+        /// \throw std::logic_error if snapshot ().valid is false.
+        bool snapshotConstraintSatisfied (const ImplicitPtr_t& constraint,
+                                          vectorOut_t error,
+                                          bool& constraintFound) const;
+
+        /// Set whether solve stores the snapshot
+        ///
+        /// Disabled by default. The storage of the snapshot is reused by the
+        /// following calls to solve.
+        void storeSnapshot (bool store)
+        {
+          storeSnapshot_ = store;
+          if (!store) snapshot_.valid = false;
+        }
+
+        /// Get whether solve stores the snapshot
+        bool storeSnapshot () const
+        {
+          return storeSnapshot_;
+        }
+
+        /// Set whether solve stores the Jacobian in the snapshot
+        ///
+        /// Only used if storeSnapshot is true.
+        void snapshotJacobian (bool store)
+        {
+          snapshotJacobian_ = store;
+        }
+
+        /// Get whether solve stores the Jacobian in the snapshot
+        bool snapshotJacobian () const
+        {
+          return snapshotJacobian_;
+        }
+
         /// Returns the lowest singular value.
         /// If the jacobian has maximum rank r, then it corresponds to r-th
         /// greatest singular value. This value is zero when the jacobian is
         /// singular.
+        /// \note If automatic scaling is enabled, the singular values are
+        ///       the ones of the scaled Jacobian.
         const value_type& sigma () const
         {
           return sigma_;
@@ -445,6 +573,161 @@ namespace hpp {
           return lastIsOptional_;
         }
 
+        /// Set automatic scaling of the linearized problem
+        ///
+        /// \param period number of descent directions computed between two
+        ///        updates of the scaling factors. 0 disables scaling.
+        ///
+        /// When enabled, the rows of each constraint are divided by the
+        /// largest norm of the constraint Jacobian rows and the columns of
+        /// the reduced Jacobian (one per free variable) are then divided
+        /// by their norm. The descent direction is computed on the scaled
+        /// problem and mapped back to the free variables. The error and the
+        /// convergence criteria are not affected and remain expressed in the
+        /// units of the constraints.
+        void automaticScaling (size_type period)
+        {
+          scalingPeriod_ = period;
+          scalingAge_ = 0;
+          invalidateFactorizations (0);
+        }
+
+        /// Get the period of the update of the automatic scaling.
+        /// \return 0 if automatic scaling is disabled.
+        size_type automaticScaling () const
+        {
+          return scalingPeriod_;
+        }
+
+        /// Set the tolerance of the reuse of the factorization of satisfied
+        /// levels
+        ///
+        /// \param tolerance maximal variation (infinity norm) of the
+        ///        configuration vector since the last decomposition of a
+        ///        level. 0 disables the reuse.
+        ///
+        /// When solving a hierarchy of constraints, a level that satisfies
+        /// the error threshold is not decomposed again if the configuration
+        /// did not change by more than the tolerance since its last
+        /// decomposition and if all the levels of higher priority are
+        /// also reused. Its contribution to the descent direction is
+        /// neglected and its previous kernel projector is used for the
+        /// following levels. The reuse is reset when the problem is
+        /// modified, when the saturation cancels some columns of the
+        /// Jacobian or when the automatic scaling is updated.
+        void refactorizationTolerance (const value_type& tolerance)
+        {
+          refactorizationTolerance_ = tolerance;
+          invalidateFactorizations (0);
+        }
+
+        /// Get the tolerance of the reuse of the factorization of satisfied
+        /// levels.
+        value_type refactorizationTolerance () const
+        {
+          return refactorizationTolerance_;
+        }
+
+        /// Set the threshold of single precision factorizations
+        ///
+        /// \param factor if positive, the reduced Jacobians are factorized
+        ///        in single precision as long as the squared error is above
+        ///        factor times the squared error threshold. The step
+        ///        computed in single precision is corrected by one step of
+        ///        iterative refinement in double precision. Closer to the
+        ///        solution, the factorizations are in double precision so
+        ///        that the accuracy of the solution is not modified.
+        ///        0 (default) disables single precision factorizations.
+        void mixedPrecision (const value_type& factor)
+        {
+          mixedPrecisionFactor_ = factor;
+          invalidateFactorizations (0);
+        }
+
+        /// Get the threshold of single precision factorizations
+        value_type mixedPrecision () const
+        {
+          return mixedPrecisionFactor_;
+        }
+
+        /// Enable or disable active bound steps
+        ///
+        /// When enabled, a free variable that reached a bound is removed
+        /// from the problem at all levels (its column in the reduced
+        /// Jacobian is set to zero) when the gradient of the error or the
+        /// previous step points outward. The variable is kept removed
+        /// until the gradient points inward, that is until the sign of
+        /// the bound multiplier changes. As long as the set of removed
+        /// variables does not change, the decompositions of satisfied
+        /// levels can be reused (see refactorizationTolerance).
+        ///
+        /// When disabled (default), a saturated variable is removed from
+        /// a level at each iteration if the gradient of this level points
+        /// outward.
+        void activeBoundSteps (bool enable)
+        {
+          activeBoundSteps_ = enable;
+          activeBounds_.resize (0);
+          invalidateFactorizations (0);
+        }
+
+        /// Whether active bound steps are enabled
+        bool activeBoundSteps () const
+        {
+          return activeBoundSteps_;
+        }
+
+        /// Evaluate the levels of the hierarchy in parallel
+        ///
+        /// When enabled, the function and Jacobian of each level are computed
+        /// by a task of TaskScheduler::global (). Each level writes its own
+        /// data, so that the result does not depend on the number of workers.
+        /// With one worker (default of the global scheduler), the levels are
+        /// evaluated serially. Disabled by default.
+        /// \warning the functions of all the levels must be thread safe,
+        ///          see TaskScheduler.
+        void parallelEvaluation (bool enable)
+        {
+          parallelEvaluation_ = enable;
+        }
+
+        /// Whether the levels are evaluated in parallel
+        bool parallelEvaluation () const
+        {
+          return parallelEvaluation_;
+        }
+
+        /// Record the calls to solve
+        ///
+        /// \param recorder recorder that writes each call to solve, with the
+        ///        serialized solver, the right hand side, the initial and
+        ///        final configurations, the status and the computation
+        ///        time. If empty (default), calls are not recorded.
+        /// \note The recorder is not copied with the solver.
+        void recorder (const RecorderPtr_t& recorder)
+        {
+          recorder_ = recorder;
+        }
+
+        /// Get the recorder of the calls to solve
+        const RecorderPtr_t& recorder () const
+        {
+          return recorder_;
+        }
+
+        /// Number of iterations of the last call to solve
+        size_type iterations () const
+        {
+          return iterations_;
+        }
+
+        /// Number of decompositions of levels reused during the last call to
+        /// solve (see refactorizationTolerance)
+        size_type reusedFactorizations () const
+        {
+          return reusedFactorizations_;
+        }
+
         /// \}
 
         /// \name Stack
@@ -569,6 +852,9 @@ namespace hpp {
         void computeSaturation (vectorIn_t arg) const;
         void getValue (vectorOut_t v) const;
         void getReducedJacobian (matrixOut_t J) const;
+        /// Get the Jacobian of all levels, before column reduction
+        /// \param J matrix of size dimension () x nv.
+        void getJacobian (matrixOut_t J) const;
         /// If lastIsOptional() is true, then the last level is ignored.
         /// \warning computeValue must have been called first.
         void computeError () const;
@@ -579,6 +865,12 @@ namespace hpp {
           return dq_;
         }
 
+        /// Integrate a velocity and saturate the result
+        ///
+        /// Only the Lie groups of the configuration space that contain free
+        /// variables or a non-zero velocity are integrated and saturated.
+        /// The other configuration variables of result are copied from
+        /// from.
         virtual bool integrate(vectorIn_t from, vectorIn_t velocity,
                                vectorOut_t result) const;
         /// \}
@@ -587,6 +879,7 @@ namespace hpp {
 
       protected:
         typedef Eigen::JacobiSVD <matrix_t> SVD_t;
+        typedef Eigen::JacobiSVD <Eigen::MatrixXf> SVDf_t;
 
         struct Data {
           /// \cond
@@ -597,8 +890,21 @@ namespace hpp {
           matrix_t jacobian, reducedJ;
 
           SVD_t svd;
+          /// Single precision decomposition, used instead of svd when
+          /// singlePrecision is true.
+          SVDf_t svdf;
+          bool singlePrecision;
           matrix_t PK;
 
+          /// Scaling of the active rows of the Jacobian and scaled reduced
+          /// Jacobian, used when automatic scaling is enabled.
+          vector_t rowScaling;
+          matrix_t scaledJ;
+
+          /// Configuration at which svd and PK were computed. Empty if they
+          /// cannot be reused.
+          vector_t factorizedAt;
+
           mutable size_type maxRank;
 
           ComparisonTypes_t comparison;
@@ -607,9 +913,33 @@ namespace hpp {
           Eigen::MatrixBlocks<false,false> activeRowsOfJ;
         };
 
+        /// Lie group composing the configuration space
+        ///
+        /// Vector spaces are split into intervals of variables that are
+        /// either all free or all fixed.
+        struct Component {
+          /// Rank in LiegroupSpace::liegroupTypes
+          std::size_t rank;
+          size_type iq, nq, iv, nv;
+          bool vectorSpace;
+          /// Whether the Lie group contains free variables
+          bool selected;
+        };
+
         /// Allocate datas and update sizes of the problem
         /// Should be called whenever the stack is modified.
         void update ();
+        /// Compute the Lie groups of the configuration space and which ones
+        /// contain free variables.
+        /// Should be called whenever the free variables are modified.
+        void updateComponents ();
+
+        /// Compute the value of level i, and its jacobian if ComputeJac is
+        /// true.
+        template <bool ComputeJac>
+        void computeLevelValue (std::size_t i, vectorIn_t arg) const;
+        /// Task of TaskScheduler evaluating a level
+        template <bool ComputeJac> struct LevelValue;
 
         /// Compute which rows of the jacobian of stack_[iStack]
         /// are not zero, using the activeDerivativeParameters of the functions.
@@ -624,8 +954,27 @@ namespace hpp {
         /// dq = J(q_i)^{+} ( rhs - v_{i} )
         /// \warning computeValue<true> must have been called first.
         void computeDescentDirection () const;
+        /// Compute the row scaling of each level and the column scaling of
+        /// the free variables from the current reduced Jacobians.
+        /// \warning computeValue<true> must have been called first.
+        void computeScaling () const;
+        /// Whether the constraints of level iStack satisfy the error threshold
+        /// \warning computeValue must have been called first.
+        bool isLevelSatisfied (std::size_t iStack) const;
+        /// Forbid the reuse of the decomposition of levels from iStack.
+        void invalidateFactorizations (std::size_t iStack) const;
+        /// Update the set of variables at bounds removed from the problem
+        /// and set the corresponding columns of the reduced Jacobians to 0.
+        /// \param saturated whether at least one variable is saturated.
+        void computeActiveBounds (bool saturated) const;
         void expandDqSmall () const;
         void saturate (vectorOut_t arg) const;
+        /// Fill the snapshot from the last evaluation of the constraints
+        /// \param arg configuration at which the constraints were evaluated.
+        void takeSnapshot (vectorIn_t arg) const;
+        /// Solve without recording the call
+        template <typename LineSearchType>
+          Status impl_solve (vectorOut_t arg, LineSearchType ls) const;
 
 
         value_type squaredErrorThreshold_, inequalityThreshold_;
@@ -661,6 +1010,42 @@ namespace hpp {
         mutable vector_t OM_;
         mutable vector_t OP_;
 
+        /// Automatic scaling
+        size_type scalingPeriod_;
+        mutable size_type scalingAge_;
+        mutable vector_t columnScaling_;
+
+        /// Reuse of the decomposition of satisfied levels
+        value_type refactorizationTolerance_;
+        mutable vector_t lastConfig_;
+        /// Threshold of single precision factorizations
+        value_type mixedPrecisionFactor_;
+        /// Damping of the least squares problem of the optional last level,
+        /// relative to the square of its largest singular value. 0 disables
+        /// the damping. Set by BySubstitution when optimizing.
+        mutable value_type damping_;
+        bool activeBoundSteps_;
+        /// Free variables at bounds removed from the problem
+        mutable ArrayXb activeBounds_;
+        /// Number of iterations of the last call to solve
+        mutable size_type iterations_;
+        /// Number of decompositions reused during the last call to solve
+        mutable size_type reusedFactorizations_;
+        RecorderPtr_t recorder_;
+        /// Lie groups of the configuration space
+        std::vector<Component> components_;
+        /// Configuration intervals integrated by the last call to integrate
+        mutable segments_t integratedIntervals_;
+        /// Errors of the constraints at the end of the last call to solve
+        mutable Snapshot snapshot_;
+        bool storeSnapshot_;
+        bool snapshotJacobian_;
+        /// Velocity variables the joints of which are updated by the
+        /// kinematic functions when computing the values and Jacobians
+        /// (see PartialKinematics).
+        ArrayXb kinematicMask_;
+        bool parallelEvaluation_;
+
         friend struct lineSearch::Backtracking;
 
       protected:
@@ -41,12 +41,22 @@ namespace hpp {
       value_type initSquaredNorm = 0;
 
       // Variables for optimization only
+      // The optional last level is minimized by a damped Gauss-Newton
+      // method (Levenberg-Marquardt) in the kernel of the other levels:
+      // the damping decreases when a step reduces the cost while keeping the
+      // other levels satisfied and increases otherwise.
+      static const value_type initialDamping = 1e-3, minDamping = 1e-12,
+        maxDamping = 1e8;
       value_type previousCost = 0;
-      value_type scaling = 1.;
-      bool onlyLineSearch = false;
       vector_t qopt;
+      damping_ = optimize ? initialDamping : 0;
+      // Whether datas_ correspond to arg
+      bool evaluated = true;
 
       // Fill value and Jacobian
+      // The scaling factors are computed from the Jacobian at arg.
+      scalingAge_ = 0;
+      reusedFactorizations_ = 0;
       computeValue<true> (arg);
       computeError();
       if (optimize)
@@ -59,9 +69,15 @@ namespace hpp {
         if (!optimize) iter = std::max (maxIterations_,size_type(2)) - 2;
         initSquaredNorm = squaredNorm_;
       }
+      const size_type firstIter = iter;
+      iterations_ = 0;
 
       bool errorIsAboveThr = (squaredNorm_ > .25 * squaredErrorThreshold_);
-      if (errorIsAboveThr && reducedDimension_ == 0) return INFEASIBLE;
+      if (errorIsAboveThr && reducedDimension_ == 0) {
+        damping_ = 0;
+        takeSnapshot (arg);
+        return INFEASIBLE;
+      }
       if (optimize && !errorIsAboveThr) qopt = arg;
 
       Status status = SUCCESS;
@@ -74,19 +90,17 @@ namespace hpp {
         status = SUCCESS;
 
         // 2. Compute step
-        // onlyLineSearch is true when we only reduced the scaling.
-        if (!onlyLineSearch) {
-          previousSquaredNorm = squaredNorm_;
-          // Update the jacobian using the jacobian of the explicit system.
-          updateJacobian(arg);
-          computeSaturation(arg);
-          computeDescentDirection ();
-        }
-        // Apply scaling to avoid too large steps.
-        if (optimize) dq_ *= scaling;
+        previousSquaredNorm = squaredNorm_;
+        // Update the jacobian using the jacobian of the explicit system.
+        updateJacobian(arg);
+        computeSaturation(arg);
+        computeDescentDirection ();
         if (dq_.squaredNorm () < dqMinSquaredNorm) {
-          // We assume that the algorithm reached a local minima.
-          status = INFEASIBLE;
+          // When optimizing from a configuration that satisfies the
+          // constraints, the cost is stationary in the kernel of the other
+          // levels. Otherwise, we assume that the algorithm reached a local
+          // minima.
+          if (!optimize || qopt.size() == 0) status = INFEASIBLE;
           break;
         }
         // 3. Apply line search algorithm for the computed step
@@ -97,6 +111,7 @@ namespace hpp {
         // 4. Evaluate the error at the new point.
 	computeValue<true> (arg);
         computeError ();
+        evaluated = true;
 
 	--errorDecreased;
 	if (squaredNorm_ < previousSquaredNorm)
@@ -106,41 +121,96 @@ namespace hpp {
 
         errorIsAboveThr = (squaredNorm_ > .25 * squaredErrorThreshold_);
         // 5. In case of optimization,
-        // - if the constraints is satisfied and the cost decreased, increase
-        //   the scaling (amount of confidence in the linear approximation)
-        // - if the constraints is not satisfied, decrease the scaling and
-        //   and cancel this step.
+        // - if the constraints are satisfied and the cost decreased, accept
+        //   the step and decrease the damping. Stop when the relative
+        //   decrease of the cost is below optimizationTolerance.
+        // - otherwise, cancel the step and increase the damping.
+        // Before the constraints are satisfied for the first time, steps are
+        // accepted as when not optimizing.
         if (optimize) {
-          if (!errorIsAboveThr) {
-            value_type cost = datas_.back().error.squaredNorm();
-            if (cost < previousCost) {
-              qopt = arg;
-              previousCost = cost;
-              if (scaling < 0.5) scaling *= 2;
-            }
-            onlyLineSearch = false;
-          } else {
-            dq_ /= scaling;
-            scaling *= 0.5;
-            if (qopt.size() > 0) arg = qopt;
-            onlyLineSearch = true;
+          ++iter;
+          const value_type cost = datas_.back().error.squaredNorm();
+          if (!errorIsAboveThr && (qopt.size() == 0 || cost < previousCost)) {
+            const bool converged (qopt.size() > 0 && previousCost - cost <=
+                                  optimizationTolerance_ * previousCost);
+            qopt = arg;
+            previousCost = cost;
+            damping_ = std::max (damping_ / 3, minDamping);
+            status = SUCCESS;
+            if (converged) break;
+          } else if (qopt.size() > 0) {
+            damping_ *= 4;
+            arg = qopt;
+            computeValue<true> (arg);
+            computeError ();
+            errorIsAboveThr = (squaredNorm_ > .25 * squaredErrorThreshold_);
+            status = SUCCESS;
+            if (damping_ > maxDamping) break;
           }
+          continue;
         }
 
 	++iter;
       }
+      iterations_ = iter - firstIter;
+      damping_ = 0;
 
       if (!optimize && errorWasBelowThr) {
         if (squaredNorm_ > initSquaredNorm) {
           arg = initArg;
+          evaluated = false;
         }
+        if (evaluated) takeSnapshot (arg);
+        else snapshot_.valid = false;
         return SUCCESS;
       }
       // If optimizing, qopt is the visited configuration that satisfies the
       // constraints and has lowest cost.
-      if (optimize && qopt.size() > 0) arg = qopt;
+      if (optimize && qopt.size() > 0 && qopt != arg) {
+        arg = qopt;
+        evaluated = false;
+      }
 
       assert (!arg.hasNaN());
+      if (evaluated) takeSnapshot (arg);
+      else snapshot_.valid = false;
+      return status;
+    }
+
+    template <typename LineSearchType>
+    inline HierarchicalIterative::Status BySubstitution::cachedSolve (
+        vectorOut_t arg,
+        LineSearchType lineSearch) const
+    {
+      const vector_t rhs (rightHandSide ());
+      const CachedSolution* cached (cachedSolution (rhs, arg));
+      if (cached) {
+        if (isSatisfied (cached->config)) {
+          arg = cached->config;
+          // The Jacobian was not evaluated at the cached configuration.
+          snapshot_.valid = false;
+          ++cacheStats_.hits;
+          cacheStats_.savedIterations += cached->iterations;
+          return SUCCESS;
+        }
+        // cacheSolution may invalidate cached.
+        const size_type cachedIterations (cached->iterations);
+        vector_t q (cached->config);
+        if (impl_solve (q, false, lineSearch) == SUCCESS) {
+          arg = q;
+          ++cacheStats_.warmStarts;
+          cacheStats_.iterations += iterations_;
+          cacheStats_.savedIterations +=
+            std::max (cachedIterations - iterations_, size_type (0));
+          cacheSolution (rhs, arg, cachedIterations);
+          return SUCCESS;
+        }
+        cacheStats_.iterations += iterations_;
+      }
+      ++cacheStats_.misses;
+      Status status (impl_solve (arg, false, lineSearch));
+      cacheStats_.iterations += iterations_;
+      if (status == SUCCESS) cacheSolution (rhs, arg, iterations_);
       return status;
     }
     } // namespace solver
@@ -21,6 +21,7 @@
 
 #include <hpp/constraints/config.hh>
 #include <hpp/constraints/svd.hh>
+#include <hpp/constraints/solver/recorder.hh>
 
 namespace hpp {
   namespace constraints {
@@ -92,6 +93,47 @@ namespace hpp {
         return slope;
       }
 
+      template <typename SolverType>
+      inline bool Interpolation::operator() (const SolverType& solver, vectorOut_t arg, vectorOut_t u)
+      {
+        arg_darg.resize(arg.size());
+
+        const value_type dphi0 = 2 * computeLocalSlope(solver);
+        const value_type phi0 = solver.residualError();
+
+        if (dphi0 > 0) {
+          hppDout (error, "The descent direction is not valid: " << dphi0);
+        } else {
+          value_type alpha = 1, alphaPrev = -1, phiPrev = 0;
+
+          while (alpha > smallAlpha) {
+            darg = alpha * u;
+            solver.integrate (arg, darg, arg_darg);
+            solver.template computeValue<false> (arg_darg);
+            solver.computeError ();
+            const value_type phiAlpha = solver.residualError();
+            if (phiAlpha <= phi0 + c * alpha * dphi0) {
+              arg = arg_darg;
+              u = darg;
+              return true;
+            }
+            // Prepare next step
+            const value_type next = nextStep (phi0, dphi0, alpha, phiAlpha,
+                alphaPrev, phiPrev);
+            alphaPrev = alpha;
+            phiPrev = phiAlpha;
+            alpha = next;
+          }
+          hppDout (error, "Could find alpha such that ||f(q)||**2 + "
+              << c << " * 2*(f(q)^T * J * dq) is doing worse than "
+              "||f(q + alpha * dq)||**2");
+        }
+
+        u *= smallAlpha;
+        solver.integrate (arg, u, arg);
+        return false;
+      }
+
       template <typename SolverType>
       inline bool FixedSequence::operator() (const SolverType& solver, vectorOut_t arg, vectorOut_t darg)
       {
@@ -116,6 +158,18 @@ namespace hpp {
     inline solver::HierarchicalIterative::Status solver::HierarchicalIterative::solve (
         vectorOut_t arg,
         LineSearchType lineSearch) const
+    {
+      if (!recorder_) return impl_solve (arg, lineSearch);
+      recorder_->start (*this, arg, lineSearch);
+      Status status (impl_solve (arg, lineSearch));
+      recorder_->stop (*this, arg, status);
+      return status;
+    }
+
+    template <typename LineSearchType>
+    inline solver::HierarchicalIterative::Status solver::HierarchicalIterative::impl_solve (
+        vectorOut_t arg,
+        LineSearchType lineSearch) const
     {
       hppDout (info, "before projection: " << arg.transpose ());
       assert (!arg.hasNaN());
@@ -126,11 +180,18 @@ namespace hpp {
       static const value_type dqMinSquaredNorm = Eigen::NumTraits<value_type>::dummy_precision();
 
       // Fill value and Jacobian
+      iterations_ = 0;
+      reusedFactorizations_ = 0;
+      // The scaling factors are computed from the Jacobian at arg.
+      scalingAge_ = 0;
       computeValue<true> (arg);
       computeError();
 
       if (squaredNorm_ > squaredErrorThreshold_
-          && reducedDimension_ == 0) return INFEASIBLE;
+          && reducedDimension_ == 0) {
+        takeSnapshot (arg);
+        return INFEASIBLE;
+      }
 
       Status status;
       while (squaredNorm_ > squaredErrorThreshold_ && errorDecreased &&
@@ -160,6 +221,8 @@ namespace hpp {
 
       }
 
+      iterations_ = iter;
+      takeSnapshot (arg);
       hppDout (info, "number of iterations: " << iter);
       if (squaredNorm_ > squaredErrorThreshold_) {
 	hppDout (info, "Projection failed.");
@@ -0,0 +1,226 @@
+// Copyright (c) 2026, CNRS
+//
+// This file is part of hpp-constraints.
+// hpp-constraints is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-constraints is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-constraints. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_CONSTRAINTS_SOLVER_RECORDER_HH
+#define HPP_CONSTRAINTS_SOLVER_RECORDER_HH
+
+#include <iosfwd>
+#include <string>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include <hpp/constraints/fwd.hh>
+#include <hpp/constraints/config.hh>
+#include <hpp/constraints/solver/hierarchical-iterative.hh>
+
+namespace hpp {
+  namespace constraints {
+    namespace solver {
+      /// \addtogroup solvers
+      /// \{
+
+      /// Recorder of calls to the solve methods of solvers
+      ///
+      /// When a recorder is given to a solver with
+      /// HierarchicalIterative::recorder, each call to
+      /// HierarchicalIterative::solve or BySubstitution::solve is appended
+      /// to a binary stream with
+      /// \li the solver serialized in a boost binary archive,
+      /// \li the options of the solver that are not serialized with it,
+      /// \li the right hand side, the line search and its parameters, and
+      ///     the initial configuration,
+      /// \li the resulting configuration, status, number of iterations and
+      ///     computation time.
+      ///
+      /// The robot is not serialized: a record is read back with a robot
+      /// of the same name. Method replay runs a recorded call again and
+      /// can be used to compare the solvers of two versions of the
+      /// library on the same inputs.
+      ///
+      /// \note Calls of a BySubstitution solver with an enabled solution
+      ///       cache are not recorded, since the cached solutions are not.
+      ///       User defined line searches are replaced by the default line
+      ///       search of the solver when replaying.
+      class HPP_CONSTRAINTS_DLLAPI Recorder
+      {
+      public:
+        typedef HierarchicalIterative::Status Status;
+
+        /// Line search used by a recorded call
+        enum LineSearch {
+          CONSTANT,
+          BACKTRACKING,
+          INTERPOLATION,
+          FIXED_SEQUENCE,
+          ERROR_NORM_BASED,
+          /// User defined line search. It is replaced by the default line
+          /// search of the solver when replaying.
+          OTHER
+        };
+
+        /// Options of a recorded solver that are not serialized with it
+        struct Options {
+          /// HierarchicalIterative::automaticScaling
+          size_type automaticScaling;
+          /// HierarchicalIterative::refactorizationTolerance
+          value_type refactorizationTolerance;
+          /// HierarchicalIterative::mixedPrecision
+          value_type mixedPrecision;
+          /// HierarchicalIterative::activeBoundSteps
+          bool activeBoundSteps;
+          /// BySubstitution::automaticPromotion
+          bool automaticPromotion;
+          /// BySubstitution::optimizationTolerance
+          value_type optimizationTolerance;
+        };
+
+        /// Recorded call to solve
+        struct Record {
+          /// \cond
+          EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+          /// \endcond
+          /// Whether the solver is a BySubstitution
+          bool bySubstitution;
+          /// Argument optimize of BySubstitution::solve
+          bool optimize;
+          LineSearch lineSearch;
+          /// Parameters of the line search, in the order of the members of
+          /// its class: c, tau, smallAlpha for Backtracking, followed by
+          /// sigmaLow, sigmaHigh for Interpolation, alpha, alphaMax, K for
+          /// FixedSequence and C, K, a, b for ErrorNormBased.
+          vector_t lineSearchParameters;
+          /// Name of the robot inserted in the archive
+          std::string robotName;
+          /// Solver serialized in a boost binary archive
+          std::string solver;
+          Options options;
+          vector_t rightHandSide;
+          /// Initial and resulting configurations
+          vector_t input, output;
+          Status status;
+          size_type iterations;
+          /// Computation time in seconds
+          value_type time;
+        };
+
+        /// Create a recorder
+        ///
+        /// \param os stream where calls are written. It should be opened in
+        ///        binary mode and remain valid as long as the recorder is
+        ///        used,
+        /// \param robot robot referenced by the constraints of the recorded
+        ///        solvers.
+        static RecorderPtr_t create (std::ostream& os,
+                                     const DevicePtr_t& robot);
+
+        /// Start recording a call to solve
+        /// \param solver the solver,
+        /// \param input initial configuration,
+        /// \param ls line search,
+        /// \param optimize argument optimize of BySubstitution::solve.
+        /// \throw std::logic_error if the call cannot be replayed.
+        template <typename LineSearchType>
+        void start (const HierarchicalIterative& solver, vectorIn_t input,
+                    const LineSearchType& ls, bool optimize = false)
+        {
+          checkSolver (solver);
+          input_ = input;
+          lineSearch_ = lineSearchId (ls);
+          lineSearchParameters (ls, lineSearchParameters_);
+          optimize_ = optimize;
+          start_ = boost::posix_time::microsec_clock::universal_time ();
+        }
+
+        /// Write the call started by start
+        /// \param solver the solver,
+        /// \param output resulting configuration,
+        /// \param status status returned by solve.
+        void stop (const HierarchicalIterative& solver, vectorIn_t output,
+                   Status status);
+
+        /// Number of calls written since the creation of the recorder
+        std::size_t numberRecords () const
+        {
+          return count_;
+        }
+
+        /// Read the next record of a stream written by a recorder
+        /// \return false if the end of the stream is reached.
+        /// \throw std::runtime_error if the stream is not a valid record.
+        static bool read (std::istream& is, Record& record);
+
+        /// Build the solver of a record
+        /// \param robot robot with the name recorded in the record.
+        static shared_ptr<HierarchicalIterative> solver
+        (const Record& record, const DevicePtr_t& robot);
+
+        /// Run a recorded call again
+        ///
+        /// \param record the recorded call,
+        /// \param robot robot with the name recorded in the record,
+        /// \retval result the result of the call: output configuration,
+        ///         status, number of iterations and computation time.
+        static void replay (const Record& record, const DevicePtr_t& robot,
+                            Record& result);
+
+        static LineSearch lineSearchId (const lineSearch::Constant&)
+        { return CONSTANT; }
+        static LineSearch lineSearchId (const lineSearch::Backtracking&)
+        { return BACKTRACKING; }
+        static LineSearch lineSearchId (const lineSearch::Interpolation&)
+        { return INTERPOLATION; }
+        static LineSearch lineSearchId (const lineSearch::FixedSequence&)
+        { return FIXED_SEQUENCE; }
+        static LineSearch lineSearchId (const lineSearch::ErrorNormBased&)
+        { return ERROR_NORM_BASED; }
+        template <typename LineSearchType>
+        static LineSearch lineSearchId (const LineSearchType&)
+        { return OTHER; }
+
+        static void lineSearchParameters (const lineSearch::Backtracking& ls,
+                                          vector_t& parameters);
+        static void lineSearchParameters (const lineSearch::Interpolation& ls,
+                                          vector_t& parameters);
+        static void lineSearchParameters (const lineSearch::FixedSequence& ls,
+                                          vector_t& parameters);
+        static void lineSearchParameters
+        (const lineSearch::ErrorNormBased& ls, vector_t& parameters);
+        template <typename LineSearchType>
+        static void lineSearchParameters (const LineSearchType&,
+                                          vector_t& parameters)
+        { parameters.resize (0); }
+
+      protected:
+        Recorder (std::ostream& os, const DevicePtr_t& robot);
+
+      private:
+        /// Throw if the calls of solver cannot be replayed.
+        static void checkSolver (const HierarchicalIterative& solver);
+
+        std::ostream& os_;
+        DevicePtr_t robot_;
+        std::size_t count_;
+        vector_t input_;
+        LineSearch lineSearch_;
+        vector_t lineSearchParameters_;
+        bool optimize_;
+        boost::posix_time::ptime start_;
+      }; // class Recorder
+      /// \}
+    } // namespace solver
+  } // namespace constraints
+} // namespace hpp
+
+#endif // HPP_CONSTRAINTS_SOLVER_RECORDER_HH
@@ -98,6 +98,7 @@ namespace hpp {
     template <typename LhsValue, typename RhsValue> class Sum;
     template <typename RhsValue> class ScalarMultiply;
     template <typename RhsValue> class RotationMultiply;
+    template <typename RhsValue> class Norm;
     typedef eigen::matrix3_t CrossMatrix;
     typedef Eigen::Matrix <value_type, 1, Eigen::Dynamic, Eigen::RowMajor> RowJacobianMatrix;
     typedef Eigen::Matrix <value_type, 3, Eigen::Dynamic, Eigen::RowMajor> JacobianMatrix;
@@ -585,6 +586,62 @@ namespace hpp {
         bool transpose_;
     };
 
+    /// Euclidean norm of an expression.
+    ///
+    /// The Jacobian of the norm is not defined at zero. It is set to zero
+    /// there.
+    template <typename RhsValue>
+    class Norm :
+      public CalculusBase < Norm < RhsValue >, Eigen::Matrix<value_type,1,1>, RowJacobianMatrix >
+    {
+      public:
+        typedef CalculusBase < Norm < RhsValue >, Eigen::Matrix<value_type,1,1>, RowJacobianMatrix >
+          Parent_t;
+
+        HPP_CONSTRAINTS_CB_CREATE1 (Norm, const typename Traits<RhsValue>::Ptr_t&)
+
+        Norm () {}
+
+        Norm (const CalculusBase <Norm>& other) :
+          Parent_t (other),
+          rhs_ (static_cast <const Norm&>(other).rhs_)
+        {}
+
+        Norm (const typename Traits<RhsValue>::Ptr_t& rhs):
+          rhs_ (rhs)
+        {}
+
+        void impl_value (const ConfigurationIn_t arg) {
+          rhs_->computeValue (arg);
+          this->value_[0] = rhs_->value ().norm ();
+        }
+        void impl_jacobian (const ConfigurationIn_t arg) {
+          this->computeValue (arg);
+          rhs_->computeJacobian (arg);
+          const value_type n = this->value_[0];
+          if (n > Eigen::NumTraits<value_type>::dummy_precision ())
+            this->jacobian_.noalias () =
+              (rhs_->value ().transpose () / n) * rhs_->jacobian ();
+          else
+            this->jacobian_.setZero (1, rhs_->jacobian ().cols ());
+        }
+        void invalidate () {
+          Parent_t::invalidate ();
+          rhs_->invalidate ();
+        }
+
+      protected:
+        typename Traits<RhsValue>::Ptr_t rhs_;
+    };
+
+    /// Euclidean norm of an expression
+    template <typename RhsValue>
+    typename Traits < Norm < RhsValue > >::Ptr_t norm
+    (const HPP_CONSTRAINTS_CB_REF <RhsValue>& rhs)
+    {
+      return Norm <RhsValue>::create (rhs);
+    }
+
     /// Basic expression representing a point in a joint frame.
     class PointInJoint : public CalculusBase <PointInJoint>
     {
@@ -916,6 +973,188 @@ namespace hpp {
         EIGEN_MAKE_ALIGNED_OPERATOR_NEW
     };
 
+    /// Basic expression representing the logarithm of a relative orientation.
+    ///
+    /// The value is \f$\log (R_1^T R_2)\f$ where \f$R_1\f$ and \f$R_2\f$ are
+    /// the orientations of two joints. If the first joint is NULL, the
+    /// orientation of the second joint is expressed in the world frame.
+    ///
+    /// As other joint based expressions, the value and the Jacobian are
+    /// computed from the current transformations and Jacobians of the joints:
+    /// the forward kinematics of the robot is not recomputed.
+    class RotationLog : public CalculusBase <RotationLog>
+    {
+      public:
+        typedef CalculusBase <RotationLog> Parent_t;
+
+        HPP_CONSTRAINTS_CB_CREATE1 (RotationLog, const JointPtr_t&)
+        HPP_CONSTRAINTS_CB_CREATE2 (RotationLog, const JointPtr_t&, const JointPtr_t&)
+
+        RotationLog () {}
+
+        RotationLog (const Parent_t& other) :
+          Parent_t (other),
+          joint1_ (static_cast <const RotationLog&>(other).joint1 ()),
+          joint2_ (static_cast <const RotationLog&>(other).joint2 ())
+        {}
+
+        RotationLog (const RotationLog& rl) :
+          Parent_t (rl), joint1_ (rl.joint1 ()), joint2_ (rl.joint2 ())
+        {}
+
+        /// Constructor
+        ///
+        /// \param joint joint the orientation of which in the world frame
+        ///        is considered.
+        RotationLog (const JointPtr_t& joint) :
+          joint1_ (), joint2_ (joint)
+        {
+          assert (joint2_ != NULL);
+        }
+
+        /// Constructor
+        ///
+        /// \param joint1 reference joint, may be NULL,
+        /// \param joint2 joint the orientation of which is considered.
+        RotationLog (const JointPtr_t& joint1, const JointPtr_t& joint2) :
+          joint1_ (joint1), joint2_ (joint2)
+        {
+          assert (joint2_ != NULL);
+        }
+
+        const JointPtr_t& joint1 () const {
+          return joint1_;
+        }
+        const JointPtr_t& joint2 () const {
+          return joint2_;
+        }
+        /// Angle of the relative rotation, valid after computeValue.
+        value_type theta () const {
+          return theta_;
+        }
+        /// Relative rotation \f$R_1^T R_2\f$, valid after computeValue.
+        const matrix3_t& rotation () const {
+          return R_;
+        }
+        /// Jacobian of the logarithm, valid after computeJacobian.
+        const matrix3_t& Jlog () const {
+          return Jlog_;
+        }
+        void impl_value (const ConfigurationIn_t ) {
+          if (joint1_)
+            R_.noalias () =
+              joint1_->currentTransformation ().rotation ().transpose ()
+              * joint2_->currentTransformation ().rotation ();
+          else
+            R_ = joint2_->currentTransformation ().rotation ();
+          logSO3 (R_, theta_, this->value_);
+        }
+        void impl_jacobian (const ConfigurationIn_t arg) {
+          computeValue (arg);
+          assert (theta_ >= 0);
+          JlogSO3 (theta_, this->value_, Jlog_);
+          // Angular velocity of joint2 with respect to joint1, expressed in
+          // joint2 frame: w2 - R^T w1
+          this->jacobian_.noalias () = Jlog_ * joint2_->jacobian ().bottomRows<3>();
+          if (joint1_)
+            this->jacobian_.noalias () -= (Jlog_ * R_.transpose ())
+              * joint1_->jacobian ().bottomRows<3>();
+        }
+
+      protected:
+        JointPtr_t joint1_, joint2_;
+        matrix3_t R_, Jlog_;
+        value_type theta_;
+
+      public:
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    };
+
+    /// Basic expression representing the pose of a joint in the frame of
+    /// another joint.
+    ///
+    /// The value is \f$(R_1^T (\mathbf{p}_2-\mathbf{p}_1),
+    /// \log (R_1^T R_2))\f$, the same as RelativeTransformation with
+    /// identity frames in the joints. The orientation part is computed by
+    /// a RotationLog that can be shared with other expressions.
+    class RelativeFrame : public CalculusBase <RelativeFrame, Eigen::Matrix<value_type, 6, 1>, Eigen::Matrix<value_type, 6, Eigen::Dynamic> >
+    {
+      public:
+        typedef CalculusBase <RelativeFrame, ValueType_t, JacobianType_t > Parent_t;
+
+        HPP_CONSTRAINTS_CB_CREATE2 (RelativeFrame, const JointPtr_t&, const JointPtr_t&)
+
+        RelativeFrame () {}
+
+        RelativeFrame (const Parent_t& other) :
+          Parent_t (other),
+          joint1_ (static_cast <const RelativeFrame&>(other).joint1_),
+          joint2_ (static_cast <const RelativeFrame&>(other).joint2_),
+          log_ (static_cast <const RelativeFrame&>(other).log_)
+        {}
+
+        RelativeFrame (const RelativeFrame& rf) :
+          Parent_t (rf), joint1_ (rf.joint1 ()), joint2_ (rf.joint2 ()),
+          log_ (rf.rotationLog ())
+        {}
+
+        /// Constructor
+        ///
+        /// \param joint1 reference joint,
+        /// \param joint2 joint the pose of which is considered.
+        RelativeFrame (const JointPtr_t& joint1, const JointPtr_t& joint2) :
+          joint1_ (joint1), joint2_ (joint2),
+          log_ (RotationLog::create (joint1, joint2))
+        {
+          assert (joint1_ != NULL && joint2_ != NULL);
+        }
+
+        const JointPtr_t& joint1 () const {
+          return joint1_;
+        }
+        const JointPtr_t& joint2 () const {
+          return joint2_;
+        }
+        /// Orientation part of the expression
+        const Traits<RotationLog>::Ptr_t& rotationLog () const {
+          return log_;
+        }
+        void impl_value (const ConfigurationIn_t arg) {
+          const Transform3f& M1 = joint1_->currentTransformation ();
+          const Transform3f& M2 = joint2_->currentTransformation ();
+          log_->computeValue (arg);
+          this->value_.head<3>().noalias () = M1.rotation ().transpose ()
+            * (M2.translation () - M1.translation ());
+          this->value_.tail<3>() = log_->value ();
+        }
+        void impl_jacobian (const ConfigurationIn_t arg) {
+          computeValue (arg);
+          log_->computeJacobian (arg);
+          const JointJacobian_t& J1 (joint1_->jacobian ());
+          const JointJacobian_t& J2 (joint2_->jacobian ());
+          // d/dt (R1^T (p2 - p1)) = R1^T R2 v2 - v1 + [t]x w1
+          matrix3_t tx; computeCrossMatrix (this->value_.head<3>(), tx);
+          this->jacobian_.resize (6, J1.cols ());
+          this->jacobian_.topRows<3>().noalias () =
+            log_->rotation () * J2.topRows<3>();
+          this->jacobian_.topRows<3>() -= J1.topRows<3>();
+          this->jacobian_.topRows<3>().noalias () +=
+            tx * J1.bottomRows<3>();
+          this->jacobian_.bottomRows<3>() = log_->jacobian ();
+        }
+        void invalidate () {
+          Parent_t::invalidate ();
+          log_->invalidate ();
+        }
+
+      protected:
+        JointPtr_t joint1_, joint2_;
+        Traits<RotationLog>::Ptr_t log_;
+
+      public:
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    };
+
     /// Matrix having Expression elements
     template <typename ValueType = eigen::vector3_t, typename JacobianType = JacobianMatrix>
     class MatrixOfExpressions :
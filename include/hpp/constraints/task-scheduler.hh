@@ -0,0 +1,144 @@
+// Copyright (c) 2026, CNRS
+//
+// This file is part of hpp-constraints.
+// hpp-constraints is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-constraints is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-constraints. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_CONSTRAINTS_TASK_SCHEDULER_HH
+#define HPP_CONSTRAINTS_TASK_SCHEDULER_HH
+
+#include <vector>
+
+#include <hpp/pinocchio/device-sync.hh>
+
+#include <hpp/constraints/fwd.hh>
+#include <hpp/constraints/config.hh>
+
+namespace hpp {
+  namespace constraints {
+    /// Deterministic execution of loops on a pool of threads
+    ///
+    /// The tasks of a loop of size n are split into numberWorkers ()
+    /// contiguous chunks of indices. The chunks are run in parallel, the
+    /// calling thread running the first one. Each task is identified by its
+    /// index, so that the result of a loop does not depend on the number of
+    /// workers as long as the tasks write to distinct data. Method reduce
+    /// combines the values of the tasks in the order of their indices.
+    ///
+    /// A loop started while another loop of the same scheduler is running,
+    /// for instance from inside a task, is run serially in the calling
+    /// thread. With one worker, loops are run serially without
+    /// synchronization.
+    ///
+    /// \note Most functions of the library are thread safe only if the
+    ///       robot has enough DeviceData (see
+    ///       hpp::pinocchio::Device::numberDeviceData). Functions that
+    ///       modify the current configuration of the robot are not.
+    class HPP_CONSTRAINTS_DLLAPI TaskScheduler
+    {
+    public:
+      /// Body of a loop
+      struct Loop
+      {
+        virtual ~Loop () {}
+        /// Run task i
+        /// \param worker index of the worker running the task, in
+        ///        [0, numberWorkers ()).
+        virtual void run (size_type i, std::size_t worker) = 0;
+      };
+
+      /// Body of a loop leasing a DeviceData per worker
+      struct DeviceLoop
+      {
+        virtual ~DeviceLoop () {}
+        /// Run task i
+        /// \param device data leased by the worker for the whole loop.
+        virtual void run (size_type i, pinocchio::DeviceSync& device) = 0;
+      };
+
+      /// Scheduler shared by the library
+      ///
+      /// It has one worker unless numberWorkers is called.
+      static TaskScheduler& global ();
+
+      /// Constructor
+      /// \param numberWorkers number of workers, see numberWorkers.
+      explicit TaskScheduler (std::size_t numberWorkers = 1);
+
+      ~TaskScheduler ();
+
+      /// Set the number of workers
+      ///
+      /// \param n number of workers including the calling thread. 1 disables
+      ///        parallel execution, 0 selects the number of hardware
+      ///        threads.
+      /// \note This method waits for the running loop, if any.
+      /// \throw std::logic_error if called from a task of this scheduler.
+      void numberWorkers (std::size_t n);
+
+      /// Get the number of workers
+      std::size_t numberWorkers () const
+      {
+        return numberWorkers_;
+      }
+
+      /// Whether loops are run in parallel
+      bool enabled () const
+      {
+        return numberWorkers_ > 1;
+      }
+
+      /// Run loop.run (i, worker) for i in [0, n)
+      ///
+      /// If tasks throw, the exception of the first chunk that failed is
+      /// rethrown once all the chunks are over.
+      void parallelFor (size_type n, Loop& loop);
+
+      /// Run loop.run (i, device) for i in [0, n)
+      ///
+      /// Each worker leases a DeviceData of robot for the whole loop. The
+      /// number of workers is limited to robot->numberDeviceData ().
+      /// \note the tasks must not evaluate functions that lease DeviceData
+      ///       of the same robot themselves.
+      void parallelFor (size_type n, DeviceLoop& loop,
+                        const DevicePtr_t& robot);
+
+      /// Reduce the values of tasks in the order of their indices
+      ///
+      /// \param values values computed by the tasks of a loop,
+      /// \param init initial value of the accumulator,
+      /// \param op binary operation, called as op (accumulator, values [i]).
+      /// \return the accumulator.
+      template <typename T, typename BinaryOp>
+      static T reduce (const std::vector <T>& values, T init, BinaryOp op)
+      {
+        for (std::size_t i = 0; i < values.size (); ++i)
+          init = op (init, values [i]);
+        return init;
+      }
+
+    private:
+      struct Pool;
+      struct Chunks;
+      TaskScheduler (const TaskScheduler&);
+      TaskScheduler& operator= (const TaskScheduler&);
+
+      /// Run the chunks of [0, n) with numberWorkers workers
+      void run (size_type n, Chunks& chunks, std::size_t numberWorkers);
+
+      std::size_t numberWorkers_;
+      Pool* pool_;
+    }; // class TaskScheduler
+  } // namespace constraints
+} // namespace hpp
+
+#endif // HPP_CONSTRAINTS_TASK_SCHEDULER_HH
@@ -29,6 +29,8 @@
 #include <hpp/pinocchio/liegroup-element.hh>
 #include <hpp/pinocchio/joint-collection.hh>
 
+#include "liegroup-component.hh"
+
 namespace hpp {
   namespace constraints {
 
@@ -60,12 +62,12 @@ namespace hpp {
         ConfigurationIn_t goal, const vector_t& ws) :
       DifferentiableFunction (robot->configSize (), robot->numberDof (),
                               LiegroupSpace::R1 (), name),
-      robot_ (robot), weights_ ()
+      robot_ (robot), weights_ (), components_ ()
     {
-      weights(ws);
       LiegroupSpacePtr_t s (LiegroupSpace::createCopy(robot->configSpace()));
       s->mergeVectorSpaces();
       goal_ = LiegroupElement (goal, s);
+      weights(ws);
     }
 
     void ConfigurationConstraint::weights (const vector_t& ws)
@@ -89,6 +91,13 @@ namespace hpp {
               model.joints[i].idx_v(), model.joints[i].nv()).setConstant(false);
         }
       }
+      computeComponents ();
+    }
+
+    void ConfigurationConstraint::computeComponents ()
+    {
+      internal::splitComponents (*goal_.space (), weights_.array () != 0,
+                                 false, components_);
     }
 
     std::ostream& ConfigurationConstraint::print (std::ostream& o) const
@@ -98,30 +107,63 @@ namespace hpp {
       return o << decindent;
     }
 
+    void ConfigurationConstraint::difference (ConfigurationIn_t argument,
+                                              vectorOut_t result) const
+    {
+      const std::vector<pinocchio::LiegroupType>& types
+        (goal_.space ()->liegroupTypes ());
+      result.setZero ();
+      for (std::vector<Component>::const_iterator c (components_.begin ());
+           c != components_.end (); ++c) {
+        if (c->vectorSpace)
+          result.segment (c->iv, c->nv) =
+            goal_.vector ().segment (c->iq, c->nq)
+            - argument.segment (c->iq, c->nq);
+        else
+          internal::componentDifference
+            (types [c->rank], argument.segment (c->iq, c->nq),
+             goal_.vector ().segment (c->iq, c->nq),
+             result.segment (c->iv, c->nv));
+      }
+    }
+
     void ConfigurationConstraint::impl_compute (LiegroupElementRef result,
                                                 ConfigurationIn_t argument)
       const
     {
-      using namespace hpp::pinocchio;
-      LiegroupElementConstRef a (argument, goal_.space());
-      result.vector () [0] = 0.5 * weights_.dot((goal_ - a).cwiseAbs2());
+      // The terms of the unweighted variables are zero, so that the sum is
+      // computed in the same order as over the whole configuration space.
+      vector_t d (weights_.size ());
+      difference (argument, d);
+      result.vector () [0] = 0.5 * weights_.dot (d.cwiseAbs2());
     }
 
     void ConfigurationConstraint::impl_jacobian (matrixOut_t jacobian,
         ConfigurationIn_t argument) const
     {
-      using namespace hpp::pinocchio;
-
-      LiegroupElementConstRef a (argument, goal_.space());
-      jacobian.leftCols (robot_->numberDof ()).noalias() = (goal_ - a).transpose();
-
-      // Apply jacobian of the difference on the right.
-      goal_.space()->dDifference_dq0<pinocchio::InputTimesDerivative>
-        (argument, goal_.vector(),
-          jacobian.leftCols (robot_->numberDof ()));
-
-      jacobian.leftCols (robot_->numberDof ()).array()
-        *= weights_.array().transpose();
+      const std::vector<pinocchio::LiegroupType>& types
+        (goal_.space ()->liegroupTypes ());
+      vector_t d (weights_.size ());
+      difference (argument, d);
+      jacobian.setZero ();
+      for (std::vector<Component>::const_iterator c (components_.begin ());
+           c != components_.end (); ++c) {
+        if (c->vectorSpace) {
+          // The derivative of the difference is minus identity.
+          jacobian.middleCols (c->iv, c->nv).noalias () =
+            - d.segment (c->iv, c->nv).transpose ();
+        } else {
+          // Apply jacobian of the difference on the right.
+          jacobian.middleCols (c->iv, c->nv) =
+            d.segment (c->iv, c->nv).transpose ();
+          internal::componentApplyDDifferenceDq0
+            (types [c->rank], argument.segment (c->iq, c->nq),
+             goal_.vector ().segment (c->iq, c->nq),
+             jacobian.middleCols (c->iv, c->nv));
+        }
+        jacobian.middleCols (c->iv, c->nv).array()
+          *= weights_.segment (c->iv, c->nv).array().transpose();
+      }
     }
   } // namespace constraints
 } // namespace hpp
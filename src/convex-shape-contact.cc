@@ -22,6 +22,7 @@
 #include <hpp/pinocchio/liegroup-element.hh>
 
 #include <hpp/constraints/matrix-view.hh>
+#include <hpp/constraints/forward-kinematics.hh>
 
 #include <../src/generic-transformation/helper.hh>
 
@@ -156,7 +157,7 @@ namespace hpp {
       GTDataV<true, true, true, false> data (relativeTransformationModel_, robot_);
 
       data.device.currentConfiguration (argument);
-      data.device.computeForwardKinematics ();
+      computeForwardKinematics (data.device);
 
       isInside = selectConvexShapes (data.device.d(), iobject, ifloor);
       const ConvexShape& object(objectConvexShapes_[iobject]),
@@ -217,7 +218,7 @@ namespace hpp {
       GTDataJ<true, true, true, false> data (relativeTransformationModel_, robot_);
 
       data.device.currentConfiguration (argument);
-      data.device.computeForwardKinematics ();
+      computeForwardKinematics (data.device);
 
       std::size_t ifloor, iobject;
       isInside = selectConvexShapes (data.device.d(), iobject, ifloor);
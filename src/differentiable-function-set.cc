@@ -18,8 +18,84 @@
 
 #include <hpp/util/indent.hh>
 
+#include <hpp/constraints/task-scheduler.hh>
+
 namespace hpp {
   namespace constraints {
+    struct DifferentiableFunctionSet::ValueLoop : TaskScheduler::Loop
+    {
+      ValueLoop (const DifferentiableFunctionSet& set, vectorOut_t result,
+                 ConfigurationIn_t arg) :
+        set_ (set), result_ (result), arg_ (arg)
+      {}
+      void run (size_type i, std::size_t)
+      {
+        set_.computeFunction ((std::size_t) i, result_, arg_);
+      }
+      const DifferentiableFunctionSet& set_;
+      vectorOut_t result_;
+      ConfigurationIn_t arg_;
+    }; // struct DifferentiableFunctionSet::ValueLoop
+
+    struct DifferentiableFunctionSet::JacobianLoop : TaskScheduler::Loop
+    {
+      JacobianLoop (const DifferentiableFunctionSet& set,
+                    matrixOut_t jacobian, ConfigurationIn_t arg) :
+        set_ (set), jacobian_ (jacobian), arg_ (arg)
+      {}
+      void run (size_type i, std::size_t)
+      {
+        set_.computeFunctionJacobian ((std::size_t) i, jacobian_, arg_);
+      }
+      const DifferentiableFunctionSet& set_;
+      matrixOut_t jacobian_;
+      ConfigurationIn_t arg_;
+    }; // struct DifferentiableFunctionSet::JacobianLoop
+
+    void DifferentiableFunctionSet::computeFunction
+    (std::size_t i, vectorOut_t result, ConfigurationIn_t arg) const
+    {
+      const DifferentiableFunction& f = *functions_ [i];
+      f.impl_compute (result_ [i], arg);
+      result.segment (rows_ [i], f.outputSize ()) = result_ [i].vector ();
+    }
+
+    void DifferentiableFunctionSet::computeFunctionJacobian
+    (std::size_t i, matrixOut_t jacobian, ConfigurationIn_t arg) const
+    {
+      const DifferentiableFunction& f = *functions_ [i];
+      f.impl_jacobian (jacobian.middleRows (derivativeRows_ [i],
+                                            f.outputDerivativeSize ()), arg);
+    }
+
+    void DifferentiableFunctionSet::impl_compute
+    (LiegroupElementRef result, ConfigurationIn_t arg) const
+    {
+      TaskScheduler& scheduler (TaskScheduler::global ());
+      if (parallelEvaluation_ && scheduler.enabled () &&
+          functions_.size () > 1) {
+        ValueLoop loop (*this, result.vector (), arg);
+        scheduler.parallelFor ((size_type) functions_.size (), loop);
+        return;
+      }
+      for (std::size_t i = 0; i < functions_.size (); ++i)
+        computeFunction (i, result.vector (), arg);
+    }
+
+    void DifferentiableFunctionSet::impl_jacobian
+    (matrixOut_t jacobian, ConfigurationIn_t arg) const
+    {
+      TaskScheduler& scheduler (TaskScheduler::global ());
+      if (parallelEvaluation_ && scheduler.enabled () &&
+          functions_.size () > 1) {
+        JacobianLoop loop (*this, jacobian, arg);
+        scheduler.parallelFor ((size_type) functions_.size (), loop);
+        return;
+      }
+      for (std::size_t i = 0; i < functions_.size (); ++i)
+        computeFunctionJacobian (i, jacobian, arg);
+    }
+
     std::ostream& DifferentiableFunctionSet::print (std::ostream& os) const
     {
       DifferentiableFunction::print (os) << incindent;
@@ -29,21 +29,33 @@
 #include <hpp/pinocchio/liegroup.hh>
 #include <hpp/pinocchio/serialization.hh>
 
+#include "liegroup-component.hh"
+
 BOOST_CLASS_EXPORT(hpp::constraints::DifferentiableFunction)
 
 namespace hpp {
   namespace constraints {
     namespace {
-      using hpp::pinocchio::DefaultLieGroupMap;
       typedef std::vector<pinocchio::JointIndex> JointIndexVector;
 
       struct FiniteDiffRobotOp
       {
         FiniteDiffRobotOp (const DevicePtr_t& r, const value_type& epsilon)
-          : robot(r), model(robot->model()),
+          : robot(r), space(robot->configSpace()),
           epsilon(epsilon),
-          v(robot->numberDof())
-        {}
+          v(robot->numberDof()), component(robot->numberDof()),
+          iq(), nq(), iv(), nv()
+        {
+          // Store the Lie group of each velocity variable
+          size_type q = 0, dq = 0;
+          for (std::size_t k = 0; k < space->liegroupTypes().size(); ++k) {
+            iq.push_back(q); nq.push_back(space->nq(k));
+            iv.push_back(dq); nv.push_back(space->nv(k));
+            for (size_type j = 0; j < nv[k]; ++j) component[dq + j] = k;
+            q += nq[k];
+            dq += nv[k];
+          }
+        }
 
         inline value_type step (const size_type& i, const vector_t& x) const
         {
@@ -55,31 +67,55 @@ namespace hpp {
         }
 
         template <bool forward>
-        inline void integrate (const vector_t& x, const vector_t& h, const size_type& /*i*/, vector_t& result) const
+        inline void integrate (const vector_t& x, const vector_t& h, const size_type& i, vector_t& result) const
         {
           // Use only the joint corresponding to velocity index i
-          if (forward)
-            hpp::pinocchio::integrate<false, DefaultLieGroupMap> (robot, x,  h, result);
+          const std::size_t k (component[i]);
+          if (nq[k] == nv[k]) {
+            // Vector space
+            const size_type j (iq[k] + i - iv[k]);
+            result[j] = x[j] + (forward ? h[i] : -h[i]);
+          } else if (forward)
+            internal::componentIntegrate (space->liegroupTypes()[k],
+                                          x.segment(iq[k], nq[k]),
+                                          h.segment(iv[k], nv[k]),
+                                          result.segment(iq[k], nq[k]));
           else
-            hpp::pinocchio::integrate<false, DefaultLieGroupMap> (robot, x, -h, result);
+            internal::componentIntegrate (space->liegroupTypes()[k],
+                                          x.segment(iq[k], nq[k]),
+                                          -h.segment(iv[k], nv[k]),
+                                          result.segment(iq[k], nq[k]));
         }
 
         inline value_type difference (const vector_t& x0, const vector_t& x1, const size_type& i) const
         {
-          hpp::pinocchio::difference <DefaultLieGroupMap> (robot, x0, x1, v);
+          const std::size_t k (component[i]);
+          internal::componentDifference (space->liegroupTypes()[k],
+                                         x1.segment(iq[k], nq[k]),
+                                         x0.segment(iq[k], nq[k]),
+                                         v.segment(iv[k], nv[k]));
           return v[i];
         }
 
-        inline void reset (const vector_t& x, const size_type& /*i*/, vector_t& result) const
+        inline void reset (const vector_t& x, const size_type& i, vector_t& result) const
         {
           // Use only the joint corresponding to velocity index i
-          result = x;
+          const std::size_t k (component[i]);
+          if (nq[k] == nv[k]) {
+            const size_type j (iq[k] + i - iv[k]);
+            result[j] = x[j];
+          } else
+            result.segment(iq[k], nq[k]) = x.segment(iq[k], nq[k]);
         }
 
         const DevicePtr_t& robot;
-        const pinocchio::Model& model;
+        LiegroupSpacePtr_t space;
         const value_type& epsilon;
         mutable vector_t v;
+        // Rank of the Lie group of each velocity variable
+        std::vector<std::size_t> component;
+        // Configuration and velocity intervals of each Lie group
+        std::vector<size_type> iq, nq, iv, nv;
       };
 
       struct FiniteDiffVectorSpaceOp
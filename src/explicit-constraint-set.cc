@@ -26,6 +26,7 @@
 
 #include <hpp/constraints/matrix-view.hh>
 #include <hpp/constraints/explicit.hh>
+#include <hpp/constraints/task-scheduler.hh>
 
 
 namespace hpp {
@@ -40,6 +41,20 @@ namespace hpp {
           for (size_type j = 0; j < rbi.indices()[i].second; ++j)
             q.push(rbi.indices()[i].first + j);
       }
+
+      /// Whether the variables of arg in intervals are equal to value
+      bool equalValues (vectorIn_t arg, const segments_t& intervals,
+                        vectorIn_t value)
+      {
+        size_type row = 0;
+        for (std::size_t i = 0; i < intervals.size(); ++i) {
+          if (arg.segment (intervals[i].first, intervals[i].second) !=
+              value.segment (row, intervals[i].second))
+            return false;
+          row += intervals[i].second;
+        }
+        return true;
+      }
     }
 
     Eigen::ColBlockIndices ExplicitConstraintSet::activeParameters () const
@@ -53,14 +68,77 @@ namespace hpp {
       return inDers_;
     }
 
+    struct ExplicitConstraintSet::SolveLevel : TaskScheduler::Loop
+    {
+      SolveLevel (const ExplicitConstraintSet& set,
+                  const std::vector<std::size_t>& level, vectorOut_t arg) :
+        set_ (set), level_ (level), arg_ (arg)
+      {}
+      void run (size_type i, std::size_t)
+      {
+        set_.solveExplicitConstraint (level_ [i], arg_);
+      }
+      const ExplicitConstraintSet& set_;
+      const std::vector<std::size_t>& level_;
+      vectorOut_t arg_;
+    }; // struct ExplicitConstraintSet::SolveLevel
+
+    struct ExplicitConstraintSet::FunctionJacobians : TaskScheduler::Loop
+    {
+      FunctionJacobians (const ExplicitConstraintSet& set, vectorIn_t arg) :
+        set_ (set), arg_ (arg)
+      {}
+      void run (size_type i, std::size_t)
+      {
+        set_.computeFunctionJacobian (set_.nonConstantOrder_ [i], arg_);
+      }
+      const ExplicitConstraintSet& set_;
+      vectorIn_t arg_;
+    }; // struct ExplicitConstraintSet::FunctionJacobians
+
     bool ExplicitConstraintSet::solve (vectorOut_t arg) const
     {
-      for(std::size_t i = 0; i < data_.size(); ++i) {
-        solveExplicitConstraint(computationOrder_[i], arg);
+      // Constant explicit constraints do not depend on any other variable.
+      if (constantOutArgs_.nbRows () > 0) {
+        if (!constantOutValuesValid_) computeConstantOutValues ();
+        constantOutArgs_.lview (arg) = constantOutValues_;
+      }
+      TaskScheduler& scheduler (TaskScheduler::global ());
+      if (parallelEvaluation_ && scheduler.enabled () &&
+          levels_.size () < nonConstantOrder_.size ()) {
+        // The constraints of a level write distinct output variables and
+        // read variables computed by the previous levels.
+        for (std::size_t k = 0; k < levels_.size (); ++k) {
+          SolveLevel loop (*this, levels_ [k], arg);
+          scheduler.parallelFor ((size_type) levels_ [k].size (), loop);
+        }
+        return true;
+      }
+      for(std::size_t i = 0; i < nonConstantOrder_.size(); ++i) {
+        solveExplicitConstraint(nonConstantOrder_[i], arg);
       }
       return true;
     }
 
+    void ExplicitConstraintSet::computeConstantOutValues () const
+    {
+      constantOutValues_.resize (constantOutArgs_.nbRows ());
+      size_type row = 0;
+      for(std::size_t i = 0; i < data_.size(); ++i) {
+        const Data& d = data_[i];
+        if (!d.constant) continue;
+        d.constraint->outputValue(d.res_qout, d.qin, d.rhs_implicit);
+        const size_type nq (d.res_qout.space ()->nq ());
+        constantOutValues_.segment (row, nq) = d.res_qout.vector ();
+        d.solvedQin.resize (0);
+        d.solvedQout = d.res_qout.vector ();
+        d.solved = true;
+        row += nq;
+      }
+      assert (row == constantOutValues_.size ());
+      constantOutValuesValid_ = true;
+    }
+
     bool ExplicitConstraintSet::isSatisfied (vectorIn_t arg, vectorOut_t error,
 					     value_type errorThreshold)
       const
@@ -73,8 +151,13 @@ namespace hpp {
       for(std::size_t i = 0; i < data_.size(); ++i) {
         const Data& d (data_[i]);
         const DifferentiableFunction& h (d.constraint->function ());
-        h.value (d.h_value, arg);
         size_type nRows (h.outputSpace ()->nv ());
+        if (isSolved (i, arg)) {
+          error.segment (row, nRows).setZero ();
+          row += nRows;
+          continue;
+        }
+        h.value (d.h_value, arg);
         assert (*(d.h_value.space ()) == *(d.rhs_implicit.space ()));
         error.segment (row, nRows) = d.h_value - d.rhs_implicit;
         squaredNorm = std::max(squaredNorm,
@@ -92,7 +175,6 @@ namespace hpp {
     {
       // Recover default value
       if (errorThreshold == -1) errorThreshold = errorThreshold_;
-      diffSmall_.resize(errorSize_);
       return isSatisfied (arg, diffSmall_, errorThreshold);
     }
 
@@ -100,22 +182,31 @@ namespace hpp {
     (const ImplicitPtr_t& constraint, vectorIn_t arg, vectorOut_t error,
      bool& constraintFound) const
     {
-      value_type squaredNorm = 0;
-      constraintFound = false;
-      for(std::size_t i = 0; i < data_.size(); ++i) {
-        const Data& d (data_[i]);
-        if (d.constraint->functionPtr () == constraint->functionPtr ()) {
-          const DifferentiableFunction& h (d.constraint->function ());
-          h.value (d.h_value, arg);
-          assert (error.size () == h.outputSpace ()->nv ());
-          assert (*(d.h_value.space ()) == *(d.rhs_implicit.space ()));
-          error = d.h_value - d.rhs_implicit;
-          squaredNorm = error.squaredNorm ();
-          constraintFound = true;
-          return squaredNorm < errorThreshold_*errorThreshold_;
-        }
+      std::map<DifferentiableFunctionPtr_t, std::size_t>::const_iterator it
+        (functionIndex_.find (constraint->functionPtr ()));
+      constraintFound = (it != functionIndex_.end ());
+      if (!constraintFound) return false;
+      const Data& d (data_[it->second]);
+      if (isSolved (it->second, arg)) {
+        error.setZero ();
+        return true;
       }
-      return false;
+      const DifferentiableFunction& h (d.constraint->function ());
+      h.value (d.h_value, arg);
+      assert (error.size () == h.outputSpace ()->nv ());
+      assert (*(d.h_value.space ()) == *(d.rhs_implicit.space ()));
+      error = d.h_value - d.rhs_implicit;
+      return error.squaredNorm () < errorThreshold_*errorThreshold_;
+    }
+
+    bool ExplicitConstraintSet::isSolved (const std::size_t& i, vectorIn_t arg)
+      const
+    {
+      const Data& d (data_[i]);
+      if (!d.solved) return false;
+      if (d.constant && !constantOutValuesValid_) return false;
+      return equalValues (arg, d.constraint->inputConf (), d.solvedQin) &&
+        equalValues (arg, d.constraint->outputConf (), d.solvedQout);
     }
 
     size_type size(const segments_t& intervals)
@@ -134,7 +225,10 @@ namespace hpp {
       (_constraint->functionPtr ()->outputSpace()->neutral()),
       h_value (_constraint->functionPtr ()->outputSpace()),
       f_value (_constraint->explicitFunction()->outputSpace ()),
-      res_qout (_constraint->explicitFunction ()->outputSpace ())
+      res_qout (_constraint->explicitFunction ()->outputSpace ()),
+      constant (_constraint->inputConf ().empty () &&
+                _constraint->inputVelocity ().empty ()),
+      solvedQin (), solvedQout (), solved (false)
     {
       jacobian.resize(_constraint->explicitFunction ()->outputDerivativeSize(),
                       _constraint->explicitFunction ()->inputDerivativeSize());
@@ -210,7 +304,15 @@ namespace hpp {
       RowBlockIndices (constraint->outputVelocity ()).lview(derFunction_).
         setConstant(idx);
       data_.push_back (Data (constraint));
+      functionIndex_.insert (std::make_pair (constraint->functionPtr (),
+                                             data_.size() - 1));
       errorSize_ += data_.back().rhs_implicit.space()->nv();
+      diffSmall_.resize(errorSize_);
+      if (data_.back().constant) {
+        // Order of the rows follows the order in data_.
+        constantOutArgs_.addRow(outIdx.first, outIdx.second);
+        constantOutValuesValid_ = false;
+      }
 
       // Update the free dofs
       outArgs_.addRow(outIdx.first, outIdx.second);
@@ -246,9 +348,37 @@ namespace hpp {
       for(std::size_t i = 0; i < data_.size(); ++i)
         computeOrder(i, order, computed);
       assert(order == data_.size());
+      nonConstantOrder_.clear();
+      for(std::size_t i = 0; i < data_.size(); ++i)
+        if (!data_[computationOrder_[i]].constant)
+          nonConstantOrder_.push_back(computationOrder_[i]);
+      computeLevels ();
       return data_.size() - 1;
     }
 
+    void ExplicitConstraintSet::computeLevels ()
+    {
+      // The level of a constraint is one more than the highest level of the
+      // non constant constraints that compute its inputs. Constant
+      // constraints are solved before the others.
+      std::vector<std::size_t> level (data_.size (), 0);
+      levels_.clear ();
+      for (std::size_t i = 0; i < nonConstantOrder_.size (); ++i) {
+        const std::size_t iE (nonConstantOrder_[i]);
+        const segments_t& inDer (data_[iE].constraint->inputVelocity ());
+        std::size_t l = 0;
+        for (std::size_t k = 0; k < inDer.size (); ++k)
+          for (size_type j = 0; j < inDer[k].second; ++j) {
+            const int iF (derFunction_[inDer[k].first + j]);
+            if (iF >= 0 && !data_[iF].constant)
+              l = std::max (l, level[iF] + 1);
+          }
+        level[iE] = l;
+        if (levels_.size () <= l) levels_.resize (l + 1);
+        levels_[l].push_back (iE);
+      }
+    }
+
     bool ExplicitConstraintSet::contains
     (const ExplicitPtr_t& numericalConstraint) const
     {
@@ -269,6 +399,9 @@ namespace hpp {
       d.constraint->outputValue(d.res_qout, d.qin, d.rhs_implicit);
       RowBlockIndices (d.constraint->outputConf ()).lview(arg) =
         d.res_qout.vector();
+      d.solvedQin = d.qin;
+      d.solvedQout = d.res_qout.vector();
+      d.solved = true;
       assert (!arg.hasNaN());
     }
 
@@ -279,29 +412,91 @@ namespace hpp {
       jacobian.setZero();
       MatrixBlocksRef (notOutDers_, notOutDers_)
         .lview (jacobian).setIdentity();
-      // Compute the function jacobians
-      for(std::size_t i = 0; i < data_.size(); ++i) {
-        const Data& d = data_[i];
-        d.qin = RowBlockIndices (d.constraint->inputConf ()).rview(arg);
-        // Compute Jacobian of f(qin) + rhs
-        // with respect to qin.
-        d.constraint->jacobianOutputValue(d.qin, d.f_value, d.rhs_implicit,
-                                          d.jacobian);
+      // The rows of the output of constant explicit constraints are zero.
+      computeFunctionJacobians (arg);
+      for(std::size_t i = 0; i < nonConstantOrder_.size(); ++i) {
+        computeJacobian(nonConstantOrder_[i], jacobian);
       }
-      for(std::size_t i = 0; i < data_.size(); ++i) {
-        computeJacobian(computationOrder_[i], jacobian);
+    }
+
+    void ExplicitConstraintSet::jacobianProduct
+    (vectorIn_t arg, matrixIn_t G, matrixOut_t result) const
+    {
+      assert (G.cols () == configSpace_->nv ());
+      assert (result.rows () == G.rows ());
+      assert (result.cols () == notOutDers_.nbIndices ());
+      computeFunctionJacobians (arg);
+      // adjoint_ holds the derivatives of G_out q_out with respect to the
+      // variables. Going backward in the computation order, the derivative
+      // with respect to the output of a constraint is complete when the
+      // constraint is reached and is propagated to its input.
+      adjoint_.resize (G.rows (), G.cols ());
+      adjoint_.setZero ();
+      const segments_t& out (outDers_.indices ());
+      for (std::size_t k = 0; k < out.size (); ++k)
+        adjoint_.middleCols (out [k].first, out [k].second) =
+          G.middleCols (out [k].first, out [k].second);
+      for (std::size_t i = nonConstantOrder_.size (); i > 0; --i) {
+        const Data& d = data_[nonConstantOrder_[i-1]];
+        const segments_t& outDer (d.constraint->outputVelocity ());
+        const segments_t& inDer (d.constraint->inputVelocity ());
+        adjointOut_.resize (G.rows (), d.jacobian.rows ());
+        size_type col = 0;
+        for (std::size_t k = 0; k < outDer.size (); ++k) {
+          adjointOut_.middleCols (col, outDer [k].second) =
+            adjoint_.middleCols (outDer [k].first, outDer [k].second);
+          col += outDer [k].second;
+        }
+        adjointIn_.noalias () = adjointOut_ * d.jacobian;
+        col = 0;
+        for (std::size_t k = 0; k < inDer.size (); ++k) {
+          adjoint_.middleCols (inDer [k].first, inDer [k].second) +=
+            adjointIn_.middleCols (col, inDer [k].second);
+          col += inDer [k].second;
+        }
+      }
+      const segments_t& notOut (notOutDers_.indices ());
+      size_type col = 0;
+      for (std::size_t k = 0; k < notOut.size (); ++k) {
+        result.middleCols (col, notOut [k].second) =
+          adjoint_.middleCols (notOut [k].first, notOut [k].second);
+        col += notOut [k].second;
       }
     }
 
+    void ExplicitConstraintSet::computeFunctionJacobians (vectorIn_t arg) const
+    {
+      TaskScheduler& scheduler (TaskScheduler::global ());
+      if (parallelEvaluation_ && scheduler.enabled () &&
+          nonConstantOrder_.size () > 1) {
+        FunctionJacobians loop (*this, arg);
+        scheduler.parallelFor ((size_type) nonConstantOrder_.size (), loop);
+        return;
+      }
+      for(std::size_t i = 0; i < nonConstantOrder_.size(); ++i)
+        computeFunctionJacobian (nonConstantOrder_[i], arg);
+    }
+
+    void ExplicitConstraintSet::computeFunctionJacobian
+    (const std::size_t& iE, vectorIn_t arg) const
+    {
+      const Data& d = data_[iE];
+      d.qin = RowBlockIndices (d.constraint->inputConf ()).rview(arg);
+      // Compute Jacobian of f(qin) + rhs
+      // with respect to qin.
+      d.constraint->jacobianOutputValue(d.qin, d.f_value, d.rhs_implicit,
+                                        d.jacobian);
+    }
+
     void ExplicitConstraintSet::computeJacobian
     (const std::size_t& iE, matrixOut_t J) const
     {
       const Data& d = data_[iE];
       ColBlockIndices inDer (d.constraint->inputVelocity ());
-      matrix_t Jin (MatrixBlocksRef (inDer, inDers_).rview(J));
+      jacobianIn_ = MatrixBlocksRef (inDer, inDers_).rview(J);
       // Jout = d.jacobian * Jin
       MatrixBlocksRef (RowBlockIndices (d.constraint->outputVelocity ()),
-                       inDers_).lview (J) = d.jacobian * Jin;
+                       inDers_).lview (J) = d.jacobian * jacobianIn_;
     }
 
     void ExplicitConstraintSet::computeOrder
@@ -363,6 +558,8 @@ namespace hpp {
       vector_t logRhsImplicit(vector_t::Zero(d.rhs_implicit.space()->nv()));
       d.equalityIndices.lview(logRhsImplicit) = d.equalityIndices.rview(logRhs);
       d.rhs_implicit = d.rhs_implicit.space()->exp(logRhsImplicit);
+      d.solved = false;
+      if (d.constant) constantOutValuesValid_ = false;
     }
 
     void ExplicitConstraintSet::rightHandSide (vectorIn_t rhs)
@@ -384,9 +581,11 @@ namespace hpp {
           assert (ct [i] == Equality || logRhsImplicit[i] == 0);
         }
 	d.rhs_implicit = d.rhs_implicit.space()->exp(logRhsImplicit);
+        d.solved = false;
         row += d.rhs_implicit.space()->nq();
       }
       assert (row == rhs.size());
+      constantOutValuesValid_ = false;
     }
 
     bool ExplicitConstraintSet::rightHandSide
@@ -426,6 +625,8 @@ namespace hpp {
       d.equalityIndices.lview (logRhsImplicit) =
 	d.equalityIndices.rview (logRhsInput);
       d.rhs_implicit = d.rhs_implicit.space()->exp(logRhsImplicit);
+      d.solved = false;
+      if (d.constant) constantOutValuesValid_ = false;
       ComparisonTypes_t ct (d.constraint->comparisonType ());
       for (std::size_t i=0; i < ct.size (); ++i) {
         assert (ct [i] == Equality ||
@@ -0,0 +1,197 @@
+// Copyright (c) 2026, CNRS
+//
+// This file is part of hpp-constraints.
+// hpp-constraints is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-constraints is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-constraints. If not, see <http://www.gnu.org/licenses/>.
+
+#include <hpp/constraints/forward-kinematics.hh>
+
+#include <vector>
+
+#include <pinocchio/multibody/model.hpp>
+#include <pinocchio/multibody/data.hpp>
+
+#include <hpp/pinocchio/device.hh>
+#include <hpp/pinocchio/joint-collection.hh>
+
+namespace hpp {
+  namespace constraints {
+    namespace {
+      typedef ::pinocchio::JointIndex JointIndex;
+      typedef pinocchio::Model::JointModel JointModel;
+      typedef pinocchio::Data::JointData JointData;
+
+      // Joints computed by the last calls of computeForwardKinematics on a
+      // pinocchio::Data
+      struct Record
+      {
+        // The record is bound to the lifetime of the data, so that a data
+        // allocated at the address of a destroyed one gets a new record.
+        weak_ptr <pinocchio::Data> data;
+        // Configuration from which the valid joints were computed
+        Configuration_t q;
+        // Whether the joint placements (and Jacobian columns) in data
+        // correspond to q
+        std::vector <bool> valid;
+        // Placements of the valid joints, compared to the ones in data to
+        // detect computations made by other means (the robot itself, or
+        // another thread that leased the same data).
+        std::vector <Transform3f> oMi;
+        bool jacobian;
+      }; // struct Record
+
+      // Maximal number of records per thread
+      static const std::size_t maxRecords = 8;
+
+      // Velocity mask of the innermost PartialKinematics scope of the thread
+      thread_local const ArrayXb* currentMask = NULL;
+      // Joints to update, reused between calls
+      thread_local std::vector <bool> neededJoints;
+      // Joints the placement of which changed since the last call
+      thread_local std::vector <bool> changedJoints;
+      thread_local std::vector <Record> records;
+      // Number of joints computed by the last call
+      thread_local size_type lastUpdatedJoints = 0;
+
+      // Select the joints with a velocity variable in mask and their
+      // ancestors. Parents come before their children in the model.
+      void selectJoints (const pinocchio::Model& model, const ArrayXb& mask,
+                         std::vector <bool>& needed)
+      {
+        // Variables of the extra configuration space, after model.nv, are
+        // ignored.
+        needed.assign (model.njoints, false);
+        for (JointIndex i = model.njoints - 1; i > 0; --i) {
+          const JointModel& joint (model.joints [i]);
+          if (!needed [i] && joint.nv () > 0)
+            needed [i] = mask.segment (joint.idx_v (), joint.nv ()).any ();
+          if (needed [i]) needed [model.parents [i]] = true;
+        }
+      }
+
+      // Get the record of data, creating it or replacing the oldest one if
+      // needed.
+      Record& getRecord (const pinocchio::Model& model,
+                         const pinocchio::DataPtr_t& data, size_type nq)
+      {
+        std::size_t k = 0;
+        while (k < records.size ()) {
+          Record& r (records [k]);
+          if (r.data.expired ()) {
+            records.erase (records.begin () + k);
+            continue;
+          }
+          if (r.data.owner_before (data) || data.owner_before (r.data)) {
+            ++k;
+            continue;
+          }
+          if (r.valid.size () == (std::size_t) model.njoints &&
+              r.q.size () == nq)
+            return r;
+          records.erase (records.begin () + k);
+          break;
+        }
+        if (records.size () >= maxRecords) records.erase (records.begin ());
+        records.push_back (Record ());
+        Record& r (records.back ());
+        r.data = data;
+        r.q.resize (nq);
+        r.valid.assign (model.njoints, false);
+        r.oMi.resize (model.njoints);
+        r.jacobian = false;
+        return r;
+      }
+    } // namespace
+
+    void computeForwardKinematics (pinocchio::DeviceSync& device)
+    {
+      const pinocchio::Model& model (device.model ());
+      const Configuration_t& q (device.currentConfiguration ());
+      // The velocity of the robot is the velocity of the model followed by
+      // the extra configuration space, that does not move any joint.
+      const size_type numberDof (model.nv + q.size () - model.nq);
+      const ArrayXb* mask (currentMask);
+      if (mask == NULL || mask->size () != numberDof ||
+          (device.computationFlag () & pinocchio::COM)) {
+        device.computeForwardKinematics ();
+        lastUpdatedJoints = model.njoints - 1;
+        return;
+      }
+      const pinocchio::DataPtr_t& dataPtr (device.d ().data_);
+      pinocchio::Data& data (*dataPtr);
+      const bool jacobian (device.computationFlag () & pinocchio::JACOBIAN);
+      // The data is only partially up to date: the device computes
+      // everything again the next time it is asked for its kinematics,
+      // frames or geometry.
+      device.d ().invalidate ();
+
+      selectJoints (model, *mask, neededJoints);
+      Record& record (getRecord (model, dataPtr, q.size ()));
+      // Jacobian columns computed before are not valid.
+      const bool all (jacobian && !record.jacobian);
+      record.jacobian = jacobian;
+
+      // Same computations as ::pinocchio::computeJointJacobians restricted
+      // to the selected joints the configuration of which, or of one of their
+      // ancestors, changed since the last call.
+      changedJoints.assign (model.njoints, false);
+      lastUpdatedJoints = 0;
+      for (JointIndex i = 1; i < (JointIndex) model.njoints; ++i) {
+        const JointModel& joint (model.joints [i]);
+        const JointIndex parent (model.parents [i]);
+        bool changed (all || changedJoints [parent] || !record.valid [i]);
+        if (!neededJoints [i]) {
+          // Descendants of changed joints are not up to date anymore.
+          if (changed) record.valid [i] = false;
+          changedJoints [i] = changed;
+          continue;
+        }
+        changed = changed ||
+          record.q.segment (joint.idx_q (), joint.nq ()) !=
+          q.segment (joint.idx_q (), joint.nq ()) ||
+          !(data.oMi [i] == record.oMi [i]);
+        changedJoints [i] = changed;
+        if (!changed) continue;
+
+        JointData& jdata (data.joints [i]);
+        joint.calc (jdata, q);
+        data.liMi [i] = model.jointPlacements [i] * jdata.M ();
+        if (parent > 0) data.oMi [i] = data.oMi [parent] * data.liMi [i];
+        else data.oMi [i] = data.liMi [i];
+        if (jacobian)
+          joint.jointCols (data.J) = data.oMi [i].act (jdata.S ());
+
+        record.q.segment (joint.idx_q (), joint.nq ()) =
+          q.segment (joint.idx_q (), joint.nq ());
+        record.oMi [i] = data.oMi [i];
+        record.valid [i] = true;
+        ++lastUpdatedJoints;
+      }
+    }
+
+    size_type updatedJoints ()
+    {
+      return lastUpdatedJoints;
+    }
+
+    PartialKinematics::PartialKinematics (const ArrayXb& velocityMask) :
+      previous_ (currentMask)
+    {
+      currentMask = &velocityMask;
+    }
+
+    PartialKinematics::~PartialKinematics ()
+    {
+      currentMask = previous_;
+    }
+  } // namespace constraints
+} // namespace hpp
@@ -27,6 +27,7 @@
 #include <hpp/pinocchio/device.hh>
 #include <hpp/pinocchio/serialization.hh>
 
+#include <hpp/constraints/forward-kinematics.hh>
 #include <hpp/constraints/macros.hh>
 
 #include "generic-transformation/helper.hh"
@@ -203,7 +204,7 @@ namespace hpp {
       GTDataV<IsRelative, (bool)ComputePosition, (bool)ComputeOrientation, (bool)OutputR3xSO3> data (m_, robot_);
 
       data.device.currentConfiguration (argument);
-      data.device.computeForwardKinematics ();
+      computeForwardKinematics (data.device);
       compute<IsRelative, (bool)ComputePosition, (bool)ComputeOrientation, (bool)OutputR3xSO3>::error (data);
 
       result.vector() = Vindices_.rview (data.value);
@@ -221,7 +222,7 @@ namespace hpp {
       GTDataJ<IsRelative, (bool)ComputePosition, (bool)ComputeOrientation, (bool)OutputR3xSO3> data (m_, robot_);
 
       data.device.currentConfiguration (arg);
-      data.device.computeForwardKinematics ();
+      computeForwardKinematics (data.device);
       compute<IsRelative, (bool)ComputePosition, (bool)ComputeOrientation, (bool)OutputR3xSO3>::error (data);
       compute<IsRelative, (bool)ComputePosition, (bool)ComputeOrientation, (bool)OutputR3xSO3>::jacobian (data, jacobian, mask_);
       }
@@ -0,0 +1,167 @@
+// Copyright (c) 2026, CNRS
+//
+// This file is part of hpp-constraints.
+// hpp-constraints is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-constraints is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-constraints. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_CONSTRAINTS_SRC_LIEGROUP_COMPONENT_HH
+#define HPP_CONSTRAINTS_SRC_LIEGROUP_COMPONENT_HH
+
+#include <vector>
+
+#include <boost/variant.hpp>
+
+#include <hpp/pinocchio/liegroup.hh>
+#include <hpp/pinocchio/liegroup-space.hh>
+
+#include <hpp/constraints/fwd.hh>
+
+// Operations on one of the Lie groups composing a LiegroupSpace. They let
+// integrate and difference be restricted to the joints that are actually
+// moved instead of the whole configuration.
+
+namespace hpp {
+  namespace constraints {
+    namespace internal {
+      typedef hpp::pinocchio::LiegroupType LiegroupType;
+
+      struct ComponentIntegrateVisitor : public boost::static_visitor <>
+      {
+        ComponentIntegrateVisitor (vectorIn_t q, vectorIn_t v,
+                                   vectorOut_t result) :
+          q_ (q), v_ (v), result_ (result)
+        {
+        }
+
+        template <typename LgT> void operator () (const LgT& lg)
+        {
+          lg.integrate (q_, v_, result_);
+        }
+
+        vectorIn_t q_, v_;
+        vectorOut_t result_;
+      }; // struct ComponentIntegrateVisitor
+
+      struct ComponentDifferenceVisitor : public boost::static_visitor <>
+      {
+        ComponentDifferenceVisitor (vectorIn_t q0, vectorIn_t q1,
+                                    vectorOut_t result) :
+          q0_ (q0), q1_ (q1), result_ (result)
+        {
+        }
+
+        template <typename LgT> void operator () (const LgT& lg)
+        {
+          lg.difference (q0_, q1_, result_);
+        }
+
+        vectorIn_t q0_, q1_;
+        vectorOut_t result_;
+      }; // struct ComponentDifferenceVisitor
+
+      struct ComponentApplyDDifferenceDq0Visitor :
+        public boost::static_visitor <>
+      {
+        ComponentApplyDDifferenceDq0Visitor (vectorIn_t q0, vectorIn_t q1,
+                                             matrixOut_t J) :
+          q0_ (q0), q1_ (q1), J_ (J)
+        {
+        }
+
+        template <typename LgT> void operator () (const LgT& lg)
+        {
+          typename LgT::JacobianMatrix_t D (lg.nv (), lg.nv ());
+          lg.template dDifference < ::pinocchio::ARG0> (q0_, q1_, D);
+          J_.applyOnTheRight (D);
+        }
+
+        vectorIn_t q0_, q1_;
+        matrixOut_t J_;
+      }; // struct ComponentApplyDDifferenceDq0Visitor
+
+      // Integrate velocity v from configuration q of Lie group type.
+      // result may be the same vector as q.
+      inline void componentIntegrate (const LiegroupType& type, vectorIn_t q,
+                                      vectorIn_t v, vectorOut_t result)
+      {
+        ComponentIntegrateVisitor visitor (q, v, result);
+        boost::apply_visitor (visitor, type);
+      }
+
+      // Compute q1 - q0 on Lie group type.
+      inline void componentDifference (const LiegroupType& type,
+                                       vectorIn_t q0, vectorIn_t q1,
+                                       vectorOut_t result)
+      {
+        ComponentDifferenceVisitor visitor (q0, q1, result);
+        boost::apply_visitor (visitor, type);
+      }
+
+      // Multiply J on the right by the derivative of q1 - q0 with respect
+      // to q0 on Lie group type, as LiegroupSpace::dDifference_dq0 does.
+      inline void componentApplyDDifferenceDq0 (const LiegroupType& type,
+                                                vectorIn_t q0, vectorIn_t q1,
+                                                matrixOut_t J)
+      {
+        ComponentApplyDDifferenceDq0Visitor visitor (q0, q1, J);
+        boost::apply_visitor (visitor, type);
+      }
+
+      // Split the Lie groups of space into components. Lie groups that are
+      // not vector spaces are a single component, selected if one of their
+      // velocity variables is. Vector spaces are split into intervals of
+      // variables that are either all selected or all unselected.
+      //
+      // Component should have members rank (in
+      // LiegroupSpace::liegroupTypes), iq, nq, iv, nv, vectorSpace and
+      // selected.
+      // \param selected velocity variables that are selected,
+      // \param keepUnselected whether the unselected components are stored.
+      template <typename Component>
+      inline void splitComponents (const pinocchio::LiegroupSpace& space,
+                                   const ArrayXb& selected,
+                                   bool keepUnselected,
+                                   std::vector <Component>& components)
+      {
+        assert (selected.size () == space.nv ());
+        components.clear ();
+        size_type iq = 0, iv = 0;
+        for (std::size_t r = 0; r < space.liegroupTypes ().size (); ++r) {
+          const size_type nq (space.nq (r)), nv (space.nv (r));
+          Component c;
+          c.rank = r;
+          c.vectorSpace = (nq == nv);
+          if (c.vectorSpace) {
+            size_type begin = iv;
+            for (size_type i = iv + 1; i <= iv + nv; ++i) {
+              if (i < iv + nv && selected [i] == selected [begin]) continue;
+              c.iq = iq + begin - iv; c.nq = i - begin;
+              c.iv = begin; c.nv = i - begin;
+              c.selected = selected [begin];
+              if (c.selected || keepUnselected) components.push_back (c);
+              begin = i;
+            }
+          } else {
+            c.iq = iq; c.nq = nq;
+            c.iv = iv; c.nv = nv;
+            c.selected = selected.segment (iv, nv).any ();
+            if (c.selected || keepUnselected) components.push_back (c);
+          }
+          iq += nq;
+          iv += nv;
+        }
+      }
+    } // namespace internal
+  } // namespace constraints
+} // namespace hpp
+
+#endif // HPP_CONSTRAINTS_SRC_LIEGROUP_COMPONENT_HH
@@ -16,19 +16,31 @@
 
 #include <hpp/constraints/solver/by-substitution.hh>
 
+#include <algorithm>
+#include <queue>
+
+#include <Eigen/QR>
+
 #include <boost/serialization/nvp.hpp>
 
 #include <hpp/util/serialization.hh>
 
 #include <hpp/pinocchio/util.hh>
 #include <hpp/pinocchio/configuration.hh>
+#include <hpp/pinocchio/device.hh>
+#include <hpp/pinocchio/joint.hh>
+#include <hpp/pinocchio/liegroup-space.hh>
 
 #include <hpp/constraints/svd.hh>
 #include <hpp/constraints/macros.hh>
 #include <hpp/constraints/active-set-differentiable-function.hh>
+#include <hpp/constraints/generic-transformation.hh>
+#include <hpp/constraints/explicit/relative-pose.hh>
 #include <hpp/constraints/solver/impl/by-substitution.hh>
 #include <hpp/constraints/solver/impl/hierarchical-iterative.hh>
 
+#include "svd-threshold.hh"
+
 namespace hpp {
   namespace constraints {
     namespace solver {
@@ -39,6 +51,9 @@ namespace hpp {
         template bool Backtracking::operator()
           (const BySubstitution& solver, vectorOut_t arg, vectorOut_t darg);
 
+        template bool Interpolation::operator()
+          (const BySubstitution& solver, vectorOut_t arg, vectorOut_t darg);
+
         template bool FixedSequence::operator()
           (const BySubstitution& solver, vectorOut_t arg, vectorOut_t darg);
 
@@ -49,17 +64,36 @@ namespace hpp {
       BySubstitution::BySubstitution (const LiegroupSpacePtr_t& configSpace) :
         HierarchicalIterative(configSpace),
         explicit_ (configSpace),
-        JeExpanded_ (configSpace->nv (), configSpace->nv ())
+        JeExpanded_ (configSpace->nv (), configSpace->nv ()),
+        promote_ (false), promoted_ (), cacheSize_ (0), cacheRadius_ (0),
+        cacheRhsRadius_ (0), cache_ (), cacheNext_ (0), cacheStats_ (),
+        optimizationTolerance_ (1e-6)
       {}
 
       BySubstitution::BySubstitution (const BySubstitution& other) :
         HierarchicalIterative (other), explicit_ (other.explicit_),
-        Je_ (other.Je_), JeExpanded_ (other.JeExpanded_)
+        Je_ (other.Je_), JeExpanded_ (other.JeExpanded_),
+        implicitJ_ (), implicitJe_ (),
+        promote_ (other.promote_), promoted_ (),
+        cacheSize_ (other.cacheSize_), cacheRadius_ (other.cacheRadius_),
+        cacheRhsRadius_ (other.cacheRhsRadius_), cache_ (other.cache_),
+        cacheNext_ (other.cacheNext_), cacheStats_ (),
+        optimizationTolerance_ (other.optimizationTolerance_)
       {
         for (NumericalConstraints_t::iterator it (constraints_.begin ());
              it != constraints_.end (); ++it) {
           //assert (contains (*it));
         }
+        // constraints_ have been copied: associate the copies to the
+        // explicit form of the original constraints.
+        for (std::size_t i = 0; i < constraints_.size (); ++i) {
+          for (Promoted_t::const_iterator it (other.promoted_.begin ());
+               it != other.promoted_.end (); ++it) {
+            if (it->first == other.constraints_[i])
+              promoted_.push_back (std::make_pair (constraints_[i],
+                                                   it->second));
+          }
+        }
       }
 
       bool BySubstitution::add (const ImplicitPtr_t& nm,
@@ -81,6 +115,23 @@ namespace hpp {
                      enm->explicitFunction()->name()
                      << " as an explicit function.");
           }
+        } else if (promote_) {
+          ExplicitPtr_t promoted (promoteToExplicit (nm));
+          if (promoted) {
+            try {
+              addedAsExplicit = explicitConstraintSet().add (promoted) >= 0;
+            } catch (const std::logic_error& exc) {
+              hppDout (info, exc.what ());
+              addedAsExplicit = false;
+            }
+            if (addedAsExplicit) {
+              promoted_.push_back (std::make_pair (nm, promoted));
+              enm = promoted;
+            } else {
+              hppDout (info, "Could not promote " << nm->function().name()
+                       << " to an explicit constraint.");
+            }
+          }
         }
 
         if (addedAsExplicit) {
@@ -99,6 +150,7 @@ namespace hpp {
           explicitConstraintSetHasChanged();
         } else
           HierarchicalIterative::add (nm, priority);
+        clearSolutionCache ();
         hppDout (info, "Constraint has dimension "
                  << dimension());
 
@@ -106,23 +158,339 @@ namespace hpp {
         return true;
       }
 
+      namespace {
+        // Dependency graph of explicit constraints. Node i computes the
+        // configuration variables outputs [i] from the configuration
+        // variables inputs [i]. owner [j] is the node inserted in the graph
+        // that computes variable j, -1 if none. The weight of a node is the
+        // number of velocity variables it computes.
+        struct ExplicitGraph
+        {
+          ExplicitGraph (size_type nq) : owner (Eigen::VectorXi::Constant
+                                                (nq, -1)) {}
+
+          std::size_t addNode (const ExplicitPtr_t& constraint)
+          {
+            inputs.push_back (constraint->inputConf ());
+            outputs.push_back (constraint->outputConf ());
+            const segments_t& outDer (constraint->outputVelocity ());
+            size_type weight = 0;
+            for (std::size_t k = 0; k < outDer.size (); ++k)
+              weight += outDer [k].second;
+            weights.push_back (weight);
+            return inputs.size () - 1;
+          }
+
+          // Whether node i can be inserted: no inserted node computes its
+          // outputs and it does not depend on its own outputs.
+          bool compatible (std::size_t i) const
+          {
+            const segments_t& out (outputs [i]);
+            for (std::size_t k = 0; k < out.size (); ++k)
+              if ((owner.segment (out [k].first, out [k].second).array ()
+                   >= 0).any ())
+                return false;
+            std::vector <bool> visited (inputs.size (), false);
+            std::queue <const segments_t*> queue;
+            queue.push (&inputs [i]);
+            while (!queue.empty ()) {
+              const segments_t& in (*queue.front ());
+              queue.pop ();
+              for (std::size_t k = 0; k < in.size (); ++k) {
+                for (std::size_t l = 0; l < out.size (); ++l)
+                  if (BlockIndex::overlap (in [k], out [l])) return false;
+                for (size_type j = in [k].first;
+                     j < in [k].first + in [k].second; ++j) {
+                  const int node (owner [j]);
+                  if (node < 0 || visited [node]) continue;
+                  visited [node] = true;
+                  queue.push (&inputs [node]);
+                }
+              }
+            }
+            return true;
+          }
+
+          void insert (std::size_t i)
+          {
+            setOwner (i, (int) i);
+          }
+
+          void remove (std::size_t i)
+          {
+            setOwner (i, -1);
+          }
+
+          void setOwner (std::size_t i, int node)
+          {
+            const segments_t& out (outputs [i]);
+            for (std::size_t k = 0; k < out.size (); ++k)
+              owner.segment (out [k].first, out [k].second).
+                setConstant (node);
+          }
+
+          std::vector <segments_t> inputs, outputs;
+          std::vector <size_type> weights;
+          Eigen::VectorXi owner;
+        }; // struct ExplicitGraph
+
+        // Branch and bound search of the compatible subset of candidates
+        // with maximal weight. Candidates are sorted by decreasing weight.
+        struct ExplicitSplitSearch
+        {
+          ExplicitSplitSearch (ExplicitGraph& g,
+                               const std::vector <std::size_t>& c) :
+            graph (g), candidates (c), remaining (c.size () + 1, 0),
+            current (c.size (), false), best (c.size (), false),
+            bestWeight (-1)
+          {
+            for (std::size_t k = c.size (); k > 0; --k)
+              remaining [k-1] = remaining [k] + graph.weights [c [k-1]];
+          }
+
+          void search (std::size_t k, size_type weight)
+          {
+            if (weight + remaining [k] <= bestWeight) return;
+            if (k == candidates.size ()) {
+              best = current;
+              bestWeight = weight;
+              return;
+            }
+            const std::size_t node (candidates [k]);
+            if (graph.compatible (node)) {
+              graph.insert (node);
+              current [k] = true;
+              search (k + 1, weight + graph.weights [node]);
+              current [k] = false;
+              graph.remove (node);
+            }
+            search (k + 1, weight);
+          }
+
+          ExplicitGraph& graph;
+          const std::vector <std::size_t>& candidates;
+          // Sum of the weights of candidates k and after
+          std::vector <size_type> remaining;
+          std::vector <bool> current, best;
+          size_type bestWeight;
+        }; // struct ExplicitSplitSearch
+
+        struct HeavierNode
+        {
+          HeavierNode (const ExplicitGraph& g) : graph (g) {}
+          bool operator() (std::size_t i, std::size_t j) const
+          {
+            return graph.weights [i] > graph.weights [j];
+          }
+          const ExplicitGraph& graph;
+        }; // struct HeavierNode
+      } // namespace
+
+      const std::size_t BySubstitution::maxExactExplicitSplitCandidates;
+
+      std::size_t BySubstitution::add
+      (const NumericalConstraints_t& numericalConstraints,
+       const std::size_t& priority)
+      {
+        const std::vector <bool> selected
+          (explicitSplit (numericalConstraints));
+        std::size_t n = 0;
+        for (std::size_t i = 0; i < numericalConstraints.size (); ++i)
+          if (selected [i] && add (numericalConstraints [i], priority)) ++n;
+        for (std::size_t i = 0; i < numericalConstraints.size (); ++i)
+          if (!selected [i] && add (numericalConstraints [i], priority)) ++n;
+        return n;
+      }
+
+      std::vector <bool> BySubstitution::explicitSplit
+      (const NumericalConstraints_t& numericalConstraints) const
+      {
+        std::vector <bool> selected (numericalConstraints.size (), false);
+        ExplicitGraph graph (configSpace_->nq ());
+        // Explicit constraints already in the solver
+        for (std::size_t i = 0; i < explicit_.data_.size (); ++i)
+          graph.insert (graph.addNode (explicit_.data_ [i].constraint));
+        // Candidates
+        const std::size_t nFixed (explicit_.data_.size ());
+        std::vector <std::size_t> candidates, constraintIndex;
+        for (std::size_t i = 0; i < numericalConstraints.size (); ++i) {
+          const ImplicitPtr_t& nm (numericalConstraints [i]);
+          if (contains (nm)) continue;
+          ExplicitPtr_t enm (HPP_DYNAMIC_PTR_CAST (Explicit, nm));
+          if (!enm && promote_) enm = promoteToExplicit (nm);
+          // ExplicitConstraintSet only handles contiguous outputs.
+          if (!enm || enm->outputConf ().size () != 1 ||
+              enm->outputVelocity ().size () != 1) continue;
+          const ComparisonTypes_t& comp (enm->comparisonType ());
+          bool equality = true;
+          for (std::size_t j = 0; j < comp.size (); ++j)
+            equality = equality && (comp [j] == EqualToZero ||
+                                    comp [j] == Equality);
+          if (!equality) continue;
+          candidates.push_back (graph.addNode (enm));
+          constraintIndex.push_back (i);
+        }
+        // Sort by decreasing weight, candidates of same weight in the order
+        // of the set.
+        std::stable_sort (candidates.begin (), candidates.end (),
+                          HeavierNode (graph));
+        if (candidates.size () <= maxExactExplicitSplitCandidates) {
+          ExplicitSplitSearch search (graph, candidates);
+          search.search (0, 0);
+          for (std::size_t k = 0; k < candidates.size (); ++k)
+            if (search.best [k])
+              selected [constraintIndex [candidates [k] - nFixed]] = true;
+        } else {
+          for (std::size_t k = 0; k < candidates.size (); ++k) {
+            if (!graph.compatible (candidates [k])) continue;
+            graph.insert (candidates [k]);
+            selected [constraintIndex [candidates [k] - nFixed]] = true;
+          }
+        }
+        return selected;
+      }
+
       void BySubstitution::explicitConstraintSetHasChanged()
       {
         // set free variables to indices that are not output of the explicit
         // constraint.
         freeVariables (explicit_.notOutDers ().transpose ());
+        clearSolutionCache ();
+      }
+
+      void BySubstitution::solutionCache (std::size_t size, value_type radius,
+                                          value_type rhsRadius)
+      {
+        if (radius < 0 || rhsRadius < 0)
+          throw std::invalid_argument ("Radii of the solution cache must be "
+                                       "non-negative.");
+        cacheSize_ = size;
+        cacheRadius_ = radius;
+        cacheRhsRadius_ = rhsRadius;
+        clearSolutionCache ();
+        cache_.reserve (size);
+      }
+
+      const BySubstitution::CachedSolution* BySubstitution::cachedSolution
+      (vectorIn_t rhs, vectorIn_t arg) const
+      {
+        const value_type rhsRadius (std::max (cacheRhsRadius_,
+                                              errorThreshold ()));
+        const CachedSolution* res = NULL;
+        value_type dmin = cacheRadius_;
+        for (SolutionCache_t::const_iterator it (cache_.begin ());
+             it != cache_.end (); ++it) {
+          if (it->rightHandSide.size () != rhs.size ()
+              || it->config.size () != arg.size ()) continue;
+          if (rhs.size () > 0 &&
+              (it->rightHandSide - rhs).lpNorm<Eigen::Infinity> () > rhsRadius)
+            continue;
+          const value_type d ((it->config - arg).lpNorm<Eigen::Infinity> ());
+          if (d <= dmin) {
+            dmin = d;
+            res = &(*it);
+          }
+        }
+        return res;
+      }
+
+      void BySubstitution::cacheSolution (vectorIn_t rhs, vectorIn_t arg,
+                                          size_type iterations) const
+      {
+        if (cacheSize_ == 0) return;
+        CachedSolution s;
+        s.rightHandSide = rhs;
+        s.config = arg;
+        s.iterations = iterations;
+        if (cache_.size () < cacheSize_) {
+          cache_.push_back (s);
+        } else {
+          // Replace the oldest solution.
+          if (cacheNext_ >= cache_.size ()) cacheNext_ = 0;
+          cache_[cacheNext_] = s;
+          ++cacheNext_;
+        }
       }
 
       bool BySubstitution::contains
       (const ImplicitPtr_t& numericalConstraint) const
       {
         if (parent_t::contains (numericalConstraint)) return true;
-        ExplicitPtr_t expl (HPP_DYNAMIC_PTR_CAST (Explicit,
-                                                  numericalConstraint));
+        ExplicitPtr_t expl (explicitForm (numericalConstraint));
         if (!expl) return false;
         return explicit_.contains (expl);
       }
 
+      ExplicitPtr_t BySubstitution::explicitForm
+      (const ImplicitPtr_t& constraint) const
+      {
+        ExplicitPtr_t expl (HPP_DYNAMIC_PTR_CAST (Explicit, constraint));
+        if (expl) return expl;
+        for (Promoted_t::const_iterator it (promoted_.begin ());
+             it != promoted_.end (); ++it) {
+          if ((it->first == constraint) || (*(it->first) == *constraint))
+            return it->second;
+        }
+        return ExplicitPtr_t ();
+      }
+
+      namespace {
+        template <typename GenericTransformation_t>
+        bool getTransformation (const DifferentiableFunctionPtr_t& f,
+                                DevicePtr_t& robot,
+                                JointConstPtr_t& joint1,
+                                JointConstPtr_t& joint2,
+                                Transform3f& frame1, Transform3f& frame2)
+        {
+          typename GenericTransformation_t::Ptr_t t
+            (HPP_DYNAMIC_PTR_CAST (GenericTransformation_t, f));
+          if (!t) return false;
+          robot = t->robot ();
+          joint1 = t->joint1 ();
+          joint2 = t->joint2 ();
+          frame1 = t->frame1InJoint1 ();
+          frame2 = t->frame2InJoint2 ();
+          return true;
+        }
+      } // namespace
+
+      ExplicitPtr_t BySubstitution::promoteToExplicit
+      (const ImplicitPtr_t& constraint) const
+      {
+        const DifferentiableFunctionPtr_t& f (constraint->functionPtr ());
+        DevicePtr_t robot;
+        JointConstPtr_t joint1, joint2;
+        Transform3f frame1, frame2;
+        if (!getTransformation <RelativeTransformationR3xSO3>
+            (f, robot, joint1, joint2, frame1, frame2) &&
+            !getTransformation <TransformationR3xSO3>
+            (f, robot, joint1, joint2, frame1, frame2))
+          return ExplicitPtr_t ();
+        // All rows must be active and constrained by an equality.
+        const ComparisonTypes_t& comp (constraint->comparisonType ());
+        for (std::size_t i = 0; i < comp.size (); ++i)
+          if (comp[i] != EqualToZero && comp[i] != Equality)
+            return ExplicitPtr_t ();
+        size_type nRows = 0;
+        for (const segment_t s : constraint->activeRows ())
+          nRows += s.second;
+        if (nRows != f->outputDerivativeSize ()) return ExplicitPtr_t ();
+        // The robot must define the unknowns of the solver.
+        if (!robot || !joint2 || !(*robot->configSpace () == *configSpace_))
+          return ExplicitPtr_t ();
+        // Joint 2 pose must be defined by its configuration variables.
+        if (!(*joint2->configurationSpace () == *LiegroupSpace::SE3 ()) &&
+            !(*joint2->configurationSpace () == *LiegroupSpace::R3xSO3 ()))
+          return ExplicitPtr_t ();
+        // Joint 1 pose must not depend on joint 2 configuration.
+        for (JointConstPtr_t j (joint1); j && j->index () != 0;
+             j = j->parentJoint ()) {
+          if (j->index () == joint2->index ()) return ExplicitPtr_t ();
+        }
+        return explicit_::RelativePose::create
+          (f->name (), robot, joint1, joint2, frame1, frame2, comp);
+      }
+
       segments_t BySubstitution::implicitDof () const
       {
         const Eigen::MatrixXi& ioDep = explicit_.inOutDependencies();
@@ -149,6 +517,16 @@ namespace hpp {
       void BySubstitution::updateJacobian (vectorIn_t arg) const
       {
         if (explicit_.inDers().nbCols() == 0) return;
+        size_type nRows = 0;
+        for (std::size_t i = 0; i < stacks_.size (); ++i)
+          nRows += datas_[i].activeRowsOfJ.nbRows ();
+        // With few implicit rows, propagate them backward through the
+        // explicit constraints instead of building Je_, the number of
+        // columns of which is the number of input variables.
+        if (nRows < explicit_.inDers().nbCols()) {
+          updateJacobianByReverseAccumulation (arg, nRows);
+          return;
+        }
         /*                                ------
                          /   in          in u out \
                          |                        |
@@ -178,6 +556,30 @@ namespace hpp {
         }
       }
 
+      void BySubstitution::updateJacobianByReverseAccumulation
+      (vectorIn_t arg, size_type nRows) const
+      {
+        // Stack the active rows of the Jacobians of all the levels.
+        implicitJ_.resize (nRows, configSpace_->nv ());
+        size_type row = 0;
+        for (std::size_t i = 0; i < stacks_.size (); ++i) {
+          const Data& d = datas_[i];
+          const size_type n (d.activeRowsOfJ.nbRows ());
+          implicitJ_.middleRows (row, n) =
+            d.activeRowsOfJ.keepRows ().rview (d.jacobian).eval ();
+          row += n;
+        }
+        implicitJe_.resize (nRows, explicit_.notOutDers ().nbIndices ());
+        explicit_.jacobianProduct (arg, implicitJ_, implicitJe_);
+        row = 0;
+        for (std::size_t i = 0; i < stacks_.size (); ++i) {
+          Data& d = datas_[i];
+          const size_type n (d.reducedJ.rows ());
+          d.reducedJ += implicitJe_.middleRows (row, n);
+          row += n;
+        }
+      }
+
       void BySubstitution::computeActiveRowsOfJ (std::size_t iStack)
       {
         Data& d = datas_[iStack];
@@ -266,6 +668,177 @@ namespace hpp {
         saturate_->saturate (P.vector (), result, saturation_);
       }
 
+      size_type BySubstitution::decomposeTangentSpace (vectorIn_t arg) const
+      {
+        if (constraints_.empty () || reducedDimension () == 0) return 0;
+        computeValue<true> (arg);
+        updateJacobian (arg);
+        getReducedJacobian (reducedJ_);
+        tangentQr_.setThreshold (SVD_THRESHOLD);
+        tangentQr_.compute (reducedJ_.adjoint ());
+        return tangentQr_.rank ();
+      }
+
+      void BySubstitution::computeTangentSpace (vectorIn_t arg) const
+      {
+        const size_type m (freeVariables_.nbIndices ());
+        const size_type r (decomposeTangentSpace (arg));
+        // The first r columns of the orthogonal factor only depend on the
+        // first r Householder reflections.
+        rowSpaceBasis_.setIdentity (m, r);
+        if (r > 0)
+          rowSpaceBasis_.applyOnTheLeft
+            (tangentQr_.householderQ ().setLength (r));
+      }
+
+      const matrix_t& BySubstitution::tangentBasis (vectorIn_t arg) const
+      {
+        const size_type m (freeVariables_.nbIndices ());
+        const size_type r (decomposeTangentSpace (arg));
+        matrix_t kernel (matrix_t::Identity (m, m).rightCols (m - r));
+        if (r > 0) kernel.applyOnTheLeft (tangentQr_.householderQ ());
+        tangentBasis_.setZero (configSpace_->nv (), m - r);
+        for (size_type j = 0; j < m - r; ++j) {
+          freeVariables_.lview (tangentBasis_.col (j)) = kernel.col (j);
+        }
+        return tangentBasis_;
+      }
+
+      void BySubstitution::projectVectorOnTangentSpace
+      (vectorIn_t velocity, vectorOut_t result) const
+      {
+        assert (rowSpaceBasis_.rows () == freeVariables_.nbIndices ());
+        dqSmall_ = freeVariables_.rview (velocity);
+        dqSmall_.noalias () -= rowSpaceBasis_ *
+          (rowSpaceBasis_.adjoint () * dqSmall_);
+        freeVariables_.lview (result) = dqSmall_;
+      }
+
+      BySubstitution::Status BySubstitution::solvePath
+      (matrixOut_t path, value_type continuity) const
+      {
+        typedef pinocchio::LiegroupElementConstRef LgeConstRef_t;
+        if (continuity < 0)
+          throw std::invalid_argument ("Continuity weight must be "
+                                       "non-negative.");
+        const size_type K (path.cols ());
+        const size_type nv (configSpace_->nv ());
+        const size_type m (freeVariables_.nbIndices ());
+        const std::size_t end (lastIsOptional_ ? stacks_.size () - 1 :
+                               stacks_.size ());
+        static const value_type dqMinSquaredNorm =
+          NumTraits::dummy_precision();
+
+        // Particular solutions p_k, kernel bases N_k, and continuity
+        // residuals e_k = q_{k+1} - q_k + p_{k+1} - p_k.
+        std::vector <vector_t> p (K), e (K > 0 ? K - 1 : 0), z (K);
+        std::vector <matrix_t> N (K);
+        // Block-tridiagonal system in the kernel coordinates z_k
+        std::vector <matrix_t> C (K > 0 ? K - 1 : 0);
+        std::vector <vector_t> b (K);
+        std::vector <Eigen::LLT <matrix_t> > D (K);
+
+        for (size_type k = 0; k < K; ++k) {
+          vectorOut_t q (path.col (k));
+          explicit_.solve (q);
+        }
+
+        lineSearch::FixedSequence ls;
+        vector_t v (nv), f;
+        for (size_type iter = 0; iter < maxIterations_; ++iter) {
+          // 1. Linearize the constraints at each configuration.
+          bool satisfied = true;
+          for (size_type k = 0; k < K; ++k) {
+            vectorIn_t q (path.col (k));
+            computeValue<true> (q);
+            computeError ();
+            if (satisfied && (squaredNorm_ > squaredErrorThreshold_ ||
+                              !explicit_.isSatisfied (q)))
+              satisfied = false;
+            updateJacobian (q);
+
+            size_type nRows = 0;
+            for (std::size_t i = 0; i < end; ++i)
+              nRows += datas_[i].reducedJ.rows ();
+            pathJ_.resize (nRows, m);
+            f.resize (nRows);
+            size_type row = 0;
+            for (std::size_t i = 0; i < end; ++i) {
+              const Data& d = datas_[i];
+              pathJ_.middleRows (row, d.reducedJ.rows ()) = d.reducedJ;
+              f.segment (row, d.reducedJ.rows ()) =
+                d.activeRowsOfJ.keepRows ().rview (d.error);
+              row += d.reducedJ.rows ();
+            }
+            // The decomposition is only reallocated when the number of rows
+            // changes.
+            pathSvd_.setThreshold (SVD_THRESHOLD);
+            pathSvd_.compute (pathJ_, Eigen::ComputeFullU |
+                              Eigen::ComputeFullV);
+            const size_type rank (pathSvd_.rank ());
+            p[k] = - getV1 (pathSvd_, rank) *
+              (pathSvd_.singularValues ().head (rank).cwiseInverse ()
+               .asDiagonal () * (getU1 (pathSvd_, rank).adjoint () * f));
+            N[k] = getV2 (pathSvd_, rank);
+          }
+          if (satisfied) return SUCCESS;
+
+          // 2. Couple the steps of consecutive configurations.
+          for (size_type k = 0; k < K; ++k) z[k].setZero (N[k].cols ());
+          if (continuity > 0 && K > 1) {
+            for (size_type k = 0; k + 1 < K; ++k) {
+              LgeConstRef_t q0 (path.col (k), configSpace_),
+                q1 (path.col (k + 1), configSpace_);
+              v = q1 - q0;
+              e[k] = freeVariables_.rview (v);
+              e[k] += p[k + 1] - p[k];
+              C[k] = - continuity * N[k].adjoint () * N[k + 1];
+            }
+            for (size_type k = 0; k < K; ++k) {
+              b[k].setZero (N[k].cols ());
+              if (k + 1 < K) b[k] += continuity * N[k].adjoint () * e[k];
+              if (k > 0)     b[k] -= continuity * N[k].adjoint () * e[k - 1];
+            }
+            // Block Thomas algorithm: forward elimination...
+            for (size_type k = 0; k < K; ++k) {
+              const value_type c ((k > 0 && k + 1 < K) ? 2 : 1);
+              matrix_t Dk ((1 + continuity * c) *
+                           matrix_t::Identity (N[k].cols (), N[k].cols ()));
+              if (k > 0) {
+                matrix_t M (D[k - 1].solve (C[k - 1]).adjoint ());
+                Dk -= M * C[k - 1];
+                b[k] -= M * b[k - 1];
+              }
+              D[k].compute (Dk);
+            }
+            // ... and back substitution.
+            for (size_type k = K - 1; k >= 0; --k) {
+              if (k + 1 < K) b[k] -= C[k] * z[k + 1];
+              z[k] = D[k].solve (b[k]);
+            }
+          }
+
+          // 3. Update the configurations.
+          value_type dqSquaredNorm = 0;
+          for (size_type k = 0; k < K; ++k) {
+            dqSmall_ = ls.alpha * (p[k] + N[k] * z[k]);
+            dqSquaredNorm += dqSmall_.squaredNorm ();
+            v.setZero ();
+            freeVariables_.lview (v) = dqSmall_;
+            vectorOut_t q (path.col (k));
+            integrate (q, v, q);
+            explicit_.solve (q);
+          }
+          ls.alpha = ls.alphaMax - ls.K * (ls.alphaMax - ls.alpha);
+          if (dqSquaredNorm < dqMinSquaredNorm) return INFEASIBLE;
+        }
+
+        for (size_type k = 0; k < K; ++k) {
+          if (!isSatisfied (path.col (k))) return MAX_ITERATION_REACHED;
+        }
+        return SUCCESS;
+      }
+
       std::ostream& BySubstitution::print (std::ostream& os) const
       {
         os << "BySubstitution" << incendl;
@@ -290,7 +863,7 @@ namespace hpp {
       {
         if (parent_t::rightHandSideFromConfig (constraint, config))
           return true;
-        ExplicitPtr_t exp (HPP_DYNAMIC_PTR_CAST (Explicit, constraint));
+        ExplicitPtr_t exp (explicitForm (constraint));
         if (exp) {
           return explicit_.rightHandSideFromInput (exp, config);
         }
@@ -302,7 +875,7 @@ namespace hpp {
       {
         if (parent_t::rightHandSide (constraint, rhs))
           return true;
-        ExplicitPtr_t exp (HPP_DYNAMIC_PTR_CAST (Explicit, constraint));
+        ExplicitPtr_t exp (explicitForm (constraint));
         if (exp) {
           return explicit_.rightHandSide (exp, rhs);
         }
@@ -313,7 +886,7 @@ namespace hpp {
       {
 	if (parent_t::getRightHandSide ( constraint, rhs))
           return true;
-        ExplicitPtr_t exp (HPP_DYNAMIC_PTR_CAST (Explicit, constraint));
+        ExplicitPtr_t exp (explicitForm (constraint));
         if (exp) {
           return explicit_.getRightHandSide ( exp, rhs);
         }
@@ -353,7 +926,22 @@ namespace hpp {
         bool satisfied (parent_t::isConstraintSatisfied (constraint, arg, error,
                                                          constraintFound));
         if (constraintFound) return satisfied;
-        return explicit_.isConstraintSatisfied (constraint, arg, error,
+        ExplicitPtr_t exp (explicitForm (constraint));
+        return explicit_.isConstraintSatisfied (exp ? exp : constraint, arg,
+                                                error, constraintFound);
+      }
+
+      bool BySubstitution::snapshotConstraintSatisfied
+      (const ImplicitPtr_t& constraint, vectorOut_t error,
+       bool& constraintFound) const
+      {
+        constraintFound = false;
+        bool satisfied (parent_t::snapshotConstraintSatisfied
+                        (constraint, error, constraintFound));
+        if (constraintFound) return satisfied;
+        ExplicitPtr_t exp (explicitForm (constraint));
+        return explicit_.isConstraintSatisfied (exp ? exp : constraint,
+                                                snapshot ().config, error,
                                                 constraintFound);
       }
 
@@ -365,6 +953,11 @@ namespace hpp {
         LiegroupSpacePtr_t space;
         ar & BOOST_SERIALIZATION_NVP(space);
         explicit_.init(space);
+        // promote_ is kept: it applies to the constraints added below.
+        cacheSize_ = 0;
+        cacheRadius_ = cacheRhsRadius_ = 0;
+        optimizationTolerance_ = 1e-6;
+        clearSolutionCache ();
         ar & make_nvp("base", base_object<HierarchicalIterative>(*this));
       }
 
@@ -385,6 +978,8 @@ namespace hpp {
       template BySubstitution::Status BySubstitution::impl_solve
       (vectorOut_t arg, bool optimize, lineSearch::Backtracking   lineSearch) const;
       template BySubstitution::Status BySubstitution::impl_solve
+      (vectorOut_t arg, bool optimize, lineSearch::Interpolation  lineSearch) const;
+      template BySubstitution::Status BySubstitution::impl_solve
       (vectorOut_t arg, bool optimize, lineSearch::FixedSequence  lineSearch) const;
       template BySubstitution::Status BySubstitution::impl_solve
       (vectorOut_t arg, bool optimize, lineSearch::ErrorNormBased lineSearch) const;
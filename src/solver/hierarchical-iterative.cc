@@ -37,9 +37,11 @@
 #include <hpp/constraints/svd.hh>
 #include <hpp/constraints/macros.hh>
 #include <hpp/constraints/implicit.hh>
+#include <hpp/constraints/forward-kinematics.hh>
+#include <hpp/constraints/task-scheduler.hh>
 
-// #define SVD_THRESHOLD Eigen::NumTraits<value_type>::dummy_precision()
-#define SVD_THRESHOLD 1e-8
+#include "../liegroup-component.hh"
+#include "svd-threshold.hh"
 
 namespace hpp {
   namespace constraints {
@@ -59,6 +61,81 @@ namespace hpp {
           }
         }
 
+        /// Decompose J in double or single precision.
+        template <typename Data>
+        void factorize (Data& d, const matrix_t& J, bool single)
+        {
+          d.singlePrecision = single;
+          if (single) d.svdf.compute (J.cast<float> ());
+          else        d.svd .compute (J);
+        }
+
+        /// Least square solution of J x = err with the decomposition of J.
+        /// In single precision, the solution is corrected by one step of
+        /// iterative refinement with the residual computed in double
+        /// precision.
+        template <typename Data>
+        vector_t solveLeastSquares (const Data& d, const matrix_t& J,
+                                    const vector_t& err)
+        {
+          if (!d.singlePrecision) return d.svd.solve (err);
+          vector_t x (d.svdf.solve (err.cast<float> ()).template
+                      cast<value_type> ());
+          const vector_t r (err - J * x);
+          x += d.svdf.solve (r.cast<float> ()).template cast<value_type> ();
+          return x;
+        }
+
+        /// Least square solution of J x = err damped by
+        /// damping * sigma_max^2, with the decomposition svd of J
+        template <typename SVD>
+        vector_t solveDamped (const SVD& svd, const vector_t& err,
+                              value_type damping)
+        {
+          const size_type r (svd.rank ());
+          if (r == 0) return vector_t::Zero (svd.cols ());
+          const vector_t s (svd.singularValues ().head (r).
+                            template cast <value_type> ());
+          const value_type lambda (damping * s [0] * s [0]);
+          vector_t x (svd.matrixU ().leftCols (r).template cast <value_type> ()
+                      .transpose () * err);
+          x.array () *= s.array () / (s.array ().square () + lambda);
+          return svd.matrixV ().leftCols (r).template cast <value_type> () * x;
+        }
+
+        /// Least square solution of J x = err, damped if damping is
+        /// positive.
+        template <typename Data>
+        vector_t solveLeastSquares (const Data& d, const matrix_t& J,
+                                    const vector_t& err, value_type damping)
+        {
+          if (damping <= 0) return solveLeastSquares (d, J, err);
+          if (d.singlePrecision) return solveDamped (d.svdf, err, damping);
+          return solveDamped (d.svd, err, damping);
+        }
+
+        template <typename Data> size_type rank (const Data& d)
+        {
+          return d.singlePrecision ? d.svdf.rank () : d.svd.rank ();
+        }
+
+        template <typename Data>
+        value_type singularValue (const Data& d, size_type i)
+        {
+          return d.singlePrecision ?
+            (value_type) d.svdf.singularValues () [i] :
+            d.svd.singularValues () [i];
+        }
+
+        /// Orthonormal basis of the kernel of the decomposed matrix
+        template <typename Data>
+        matrix_t kernel (const Data& d, size_type rank)
+        {
+          if (d.singlePrecision)
+            return getV2 (d.svdf, rank).template cast<value_type> ();
+          return getV2 (d.svd, rank);
+        }
+
         template <bool ComputeJac>
         void applyComparison (const ComparisonTypes_t comparison,
                               const std::vector<std::size_t>& indices,
@@ -87,6 +164,41 @@ namespace hpp {
         template bool Backtracking::operator()
           (const HierarchicalIterative& solver, vectorOut_t arg, vectorOut_t darg);
 
+        Interpolation::Interpolation () : sigmaLow (0.1), sigmaHigh (0.5) {}
+
+        value_type Interpolation::nextStep (value_type phi0, value_type dphi0,
+            value_type alpha, value_type phiAlpha,
+            value_type alphaPrev, value_type phiPrev) const
+        {
+          value_type next;
+          const value_type d1 = phiAlpha - phi0 - dphi0 * alpha;
+          if (alphaPrev < 0) {
+            // Quadratic interpolation of phi(0), phi'(0) and phi(alpha).
+            next = (d1 > 0) ? - dphi0 * alpha * alpha / (2 * d1)
+              : tau * alpha;
+          } else {
+            // Cubic interpolation of phi(0), phi'(0), phi(alpha) and
+            // phi(alphaPrev).
+            const value_type d0 = phiPrev - phi0 - dphi0 * alphaPrev;
+            const value_type a2 = alpha * alpha, p2 = alphaPrev * alphaPrev;
+            const value_type den = a2 * p2 * (alpha - alphaPrev);
+            const value_type a = (p2 * d1 - a2 * d0) / den;
+            const value_type b = (- p2 * alphaPrev * d1 + a2 * alpha * d0) / den;
+            if (a == 0) {
+              next = (b > 0) ? - dphi0 / (2 * b) : tau * alpha;
+            } else {
+              const value_type disc = b * b - 3 * a * dphi0;
+              next = (disc >= 0) ? (- b + std::sqrt (disc)) / (3 * a)
+                : tau * alpha;
+            }
+          }
+          if (!std::isfinite (next)) next = tau * alpha;
+          return std::min (sigmaHigh * alpha, std::max (sigmaLow * alpha, next));
+        }
+
+        template bool Interpolation::operator()
+          (const HierarchicalIterative& solver, vectorOut_t arg, vectorOut_t darg);
+
         FixedSequence::FixedSequence() : alpha (.2), alphaMax (.95), K (.8) {}
         template bool FixedSequence::operator()
           (const HierarchicalIterative& solver, vectorOut_t arg, vectorOut_t darg);
@@ -118,6 +230,12 @@ namespace hpp {
           return false;
         }
 
+        bool Base::saturateIntervals(vectorIn_t q, vectorOut_t qSat,
+            Eigen::VectorXi& saturation, const segments_t&)
+        {
+          return saturate (q, qSat, saturation);
+        }
+
         bool clamp(const value_type& lb, const value_type& ub,
             const value_type& v, value_type& vsat, int& s)
         {
@@ -146,6 +264,18 @@ namespace hpp {
           return sat;
         }
 
+        bool Bounds::saturateIntervals(vectorIn_t q, vectorOut_t qSat,
+            Eigen::VectorXi& saturation, const segments_t& intervals)
+        {
+          bool sat = false;
+          for (segments_t::const_iterator it (intervals.begin ());
+               it != intervals.end (); ++it)
+            for (size_type i = it->first; i < it->first + it->second; ++i)
+              if (clamp(lb[i], ub[i], q[i], qSat[i], saturation[i]))
+                sat = true;
+          return sat;
+        }
+
         bool Device::saturate (vectorIn_t q, vectorOut_t qSat, Eigen::VectorXi& sat)
         {
           bool ret = false;
@@ -176,6 +306,46 @@ namespace hpp {
           }
           return ret;
         }
+
+        bool Device::saturateIntervals (vectorIn_t q, vectorOut_t qSat,
+            Eigen::VectorXi& sat, const segments_t& intervals)
+        {
+          bool ret = false;
+          const pinocchio::Model& m = device->model();
+          const hpp::pinocchio::ExtraConfigSpace& ecs = device->extraConfigSpace();
+
+          // Joints are sorted by configuration rank, as the intervals.
+          std::size_t i = 1;
+          for (segments_t::const_iterator it (intervals.begin ());
+               it != intervals.end (); ++it) {
+            const size_type begin = it->first, end = it->first + it->second;
+            while (i < m.joints.size() &&
+                   m.joints[i].idx_q() + m.joints[i].nq() <= begin)
+              ++i;
+            for (std::size_t k = i; k < m.joints.size() &&
+                   m.joints[k].idx_q() < end; ++k) {
+              const size_type nq = m.joints[k].nq();
+              const size_type nv = m.joints[k].nv();
+              const size_type idx_q = m.joints[k].idx_q();
+              const size_type idx_v = m.joints[k].idx_v();
+              for (size_type iq = std::max(begin, idx_q);
+                   iq < std::min(end, idx_q + nq); ++iq) {
+                const size_type iv = idx_v + std::min(iq - idx_q, nv-1);
+                if (clamp(m.lowerPositionLimit[iq], m.upperPositionLimit[iq],
+                      q[iq], qSat[iq], sat[iv]))
+                  ret = true;
+              }
+            }
+            for (size_type iq = std::max(begin, (size_type) m.nq); iq < end;
+                 ++iq) {
+              const size_type k = iq - m.nq;
+              const size_type iv = m.nv + k;
+              if (clamp(ecs.lower(k), ecs.upper(k), q[iq], qSat[iq], sat[iv]))
+                ret = true;
+            }
+          }
+          return ret;
+        }
       }
 
       HierarchicalIterative::HierarchicalIterative
@@ -188,10 +358,20 @@ namespace hpp {
         sigma_ (0), dq_ (), dqSmall_ (), reducedJ_ (),
         saturation_ (configSpace->nv ()), reducedSaturation_ (),
         qSat_ (configSpace_->nq ()), tmpSat_ (), squaredNorm_ (0), datas_(),
-        svd_ (), OM_ (configSpace->nv ()), OP_ (configSpace->nv ())
+        svd_ (), OM_ (configSpace->nv ()), OP_ (configSpace->nv ()),
+        scalingPeriod_ (0), scalingAge_ (0), columnScaling_ (),
+        refactorizationTolerance_ (0), lastConfig_ (),
+        mixedPrecisionFactor_ (0), damping_ (0),
+        activeBoundSteps_ (false), activeBounds_ (), iterations_ (0),
+        reusedFactorizations_ (0),
+        recorder_ (), components_ (), integratedIntervals_ (), snapshot_ (),
+        storeSnapshot_ (false), snapshotJacobian_ (false), kinematicMask_ (),
+        parallelEvaluation_ (false)
       {
+        snapshot_.valid = false;
         // Initialize freeVariables_ to all indices.
         freeVariables_.addRow (0, configSpace_->nv ());
+        updateComponents ();
       }
 
       HierarchicalIterative::HierarchicalIterative
@@ -212,8 +392,21 @@ namespace hpp {
         reducedSaturation_ (other.reducedSaturation_), qSat_ (other.qSat_),
         tmpSat_ (other.tmpSat_), squaredNorm_ (other.squaredNorm_),
         datas_ (other.datas_), svd_ (other.svd_), OM_ (other.OM_),
-	OP_ (other.OP_)
+	OP_ (other.OP_), scalingPeriod_ (other.scalingPeriod_),
+        scalingAge_ (0), columnScaling_ (other.columnScaling_),
+        refactorizationTolerance_ (other.refactorizationTolerance_),
+        lastConfig_ (other.lastConfig_),
+        mixedPrecisionFactor_ (other.mixedPrecisionFactor_), damping_ (0),
+        activeBoundSteps_ (other.activeBoundSteps_),
+        activeBounds_ (other.activeBounds_), iterations_ (0),
+        reusedFactorizations_ (0), recorder_ (),
+        components_ (other.components_), integratedIntervals_ (),
+        snapshot_ (), storeSnapshot_ (other.storeSnapshot_),
+        snapshotJacobian_ (other.snapshotJacobian_),
+        kinematicMask_ (other.kinematicMask_),
+        parallelEvaluation_ (other.parallelEvaluation_)
       {
+        snapshot_.valid = false;
         for (std::size_t i = 0; i < constraints_.size(); ++i)
           constraints_[i] = other.constraints_[i]->copy();
       }
@@ -373,16 +566,43 @@ namespace hpp {
                                  Eigen::ComputeThinU |
                                  (i==stacks_.size()-1 ? Eigen::ComputeThinV : Eigen::ComputeFullV));
           datas_[i].svd.setThreshold (SVD_THRESHOLD);
+          datas_[i].svdf = SVDf_t (f.outputDerivativeSize(), reducedSize,
+                                   Eigen::ComputeThinU |
+                                   (i==stacks_.size()-1 ? Eigen::ComputeThinV : Eigen::ComputeFullV));
+          datas_[i].svdf.setThreshold
+            (Eigen::NumTraits<float>::dummy_precision());
+          datas_[i].singlePrecision = false;
           datas_[i].PK.resize (reducedSize, reducedSize);
+          datas_[i].rowScaling = vector_t::Ones
+            (datas_[i].activeRowsOfJ.nbRows());
+          datas_[i].scaledJ.resize (datas_[i].activeRowsOfJ.nbRows(),
+                                    reducedSize);
+          datas_[i].factorizedAt.resize (0);
 
           datas_[i].maxRank = 0;
         }
+        columnScaling_ = vector_t::Ones (reducedSize);
+        scalingAge_ = 0;
+
+        // Restrict the kinematics to the joints the functions depend on.
+        kinematicMask_ = activeDerivativeParameters ();
 
         dq_ = vector_t::Zero(configSpace_->nv ());
         dqSmall_.resize(reducedSize);
         reducedJ_.resize(reducedDimension_, reducedSize);
         svd_ = SVD_t (reducedDimension_, reducedSize,
                       Eigen::ComputeThinU | Eigen::ComputeThinV);
+        updateComponents ();
+      }
+
+      void HierarchicalIterative::updateComponents ()
+      {
+        ArrayXb isFree (ArrayXb::Constant (configSpace_->nv (), false));
+        for (std::size_t k = 0; k < freeVariables_.indices ().size (); ++k) {
+          const segment_t& s (freeVariables_.indices ()[k]);
+          isFree.segment (s.first, s.second).setConstant (true);
+        }
+        internal::splitComponents (*configSpace_, isFree, true, components_);
       }
 
       void HierarchicalIterative::computeActiveRowsOfJ (std::size_t iStack)
@@ -522,6 +742,52 @@ namespace hpp {
         return (error.squaredNorm () < squaredErrorThreshold_);
       }
 
+      bool HierarchicalIterative::snapshotConstraintSatisfied
+      (const ImplicitPtr_t& constraint, vectorOut_t error,
+       bool& constraintFound) const
+      {
+        if (!snapshot_.valid)
+          throw std::logic_error ("The constraints were not evaluated at the "
+                                  "configuration returned by solve.");
+        const DifferentiableFunctionPtr_t& f (constraint->functionPtr ());
+        assert (error.size () == f->outputSpace ()->nv ());
+        std::map <DifferentiableFunctionPtr_t, std::size_t>::const_iterator itp;
+        itp = priority_.find (f);
+        if (itp == priority_.end ()) {
+          constraintFound = false;
+          return false;
+        }
+        constraintFound = true;
+        std::map <DifferentiableFunctionPtr_t, size_type>::const_iterator itIv;
+        itIv = iv_.find (f);
+        assert (itIv != iv_.end ());
+        // Row of the level in the error
+        size_type row = 0;
+        for (std::size_t i = 0; i < itp->second; ++i)
+          row += datas_[i].error.size ();
+        error = snapshot_.error.segment (row + itIv->second, error.size ());
+        return (error.squaredNorm () < squaredErrorThreshold_);
+      }
+
+      void HierarchicalIterative::takeSnapshot (vectorIn_t arg) const
+      {
+        if (!storeSnapshot_) {
+          snapshot_.valid = false;
+          return;
+        }
+        snapshot_.valid = true;
+        snapshot_.config = arg;
+        snapshot_.error.resize (dimension_);
+        residualError (snapshot_.error);
+        snapshot_.squaredNorm = squaredNorm_;
+        if (snapshotJacobian_) {
+          snapshot_.jacobian.resize (dimension_, configSpace_->nv ());
+          getJacobian (snapshot_.jacobian);
+        } else {
+          snapshot_.jacobian.resize (0, 0);
+        }
+      }
+
       void HierarchicalIterative::rightHandSide (vectorIn_t rightHandSide)
       {
         size_type iq = 0, iv = 0;
@@ -587,27 +853,58 @@ namespace hpp {
       }
 
       template <bool ComputeJac>
-      void HierarchicalIterative::computeValue (vectorIn_t config) const
+      struct HierarchicalIterative::LevelValue : TaskScheduler::Loop
       {
-        for (std::size_t i = 0; i < stacks_.size (); ++i) {
-          const ImplicitConstraintSet& constraints (stacks_ [i]);
-          const DifferentiableFunction& f = constraints.function ();
-          Data& d = datas_[i];
+        LevelValue (const HierarchicalIterative& solver, vectorIn_t config) :
+          solver_ (solver), config_ (config)
+        {}
+        void run (size_type i, std::size_t)
+        {
+          // The restriction of the kinematics applies to the calling thread.
+          PartialKinematics kinematics (solver_.kinematicMask_);
+          solver_.computeLevelValue<ComputeJac> ((std::size_t) i, config_);
+        }
+        const HierarchicalIterative& solver_;
+        vectorIn_t config_;
+      }; // struct HierarchicalIterative::LevelValue
 
-          f.value   (d.output, config);
-          d.error = d.output - d.rightHandSide;
-	  constraints.setInactiveRowsToZero(d.error);
-          if (ComputeJac) {
-            f.jacobian(d.jacobian, config);
-            d.output.space()->dDifference_dq1<pinocchio::DerivativeTimesInput>
-              (d.rightHandSide.vector(), d.output.vector(), d.jacobian);
-          }
-          applyComparison<ComputeJac>(d.comparison, d.inequalityIndices,
-                                      d.error, d.jacobian, inequalityThreshold_);
+      template <bool ComputeJac>
+      void HierarchicalIterative::computeLevelValue
+      (std::size_t i, vectorIn_t config) const
+      {
+        const ImplicitConstraintSet& constraints (stacks_ [i]);
+        const DifferentiableFunction& f = constraints.function ();
+        Data& d = datas_[i];
+
+        f.value   (d.output, config);
+        d.error = d.output - d.rightHandSide;
+        constraints.setInactiveRowsToZero(d.error);
+        if (ComputeJac) {
+          f.jacobian(d.jacobian, config);
+          d.output.space()->dDifference_dq1<pinocchio::DerivativeTimesInput>
+            (d.rightHandSide.vector(), d.output.vector(), d.jacobian);
+        }
+        applyComparison<ComputeJac>(d.comparison, d.inequalityIndices,
+                                    d.error, d.jacobian, inequalityThreshold_);
+
+        // Copy columns that are not reduced
+        if (ComputeJac) d.reducedJ = d.activeRowsOfJ.rview (d.jacobian);
+      }
 
-          // Copy columns that are not reduced
-          if (ComputeJac) d.reducedJ = d.activeRowsOfJ.rview (d.jacobian);
+      template <bool ComputeJac>
+      void HierarchicalIterative::computeValue (vectorIn_t config) const
+      {
+        if (ComputeJac && refactorizationTolerance_ > 0) lastConfig_ = config;
+        TaskScheduler& scheduler (TaskScheduler::global ());
+        if (parallelEvaluation_ && scheduler.enabled () &&
+            stacks_.size () > 1) {
+          LevelValue<ComputeJac> loop (*this, config);
+          scheduler.parallelFor ((size_type) stacks_.size (), loop);
+          return;
         }
+        PartialKinematics kinematics (kinematicMask_);
+        for (std::size_t i = 0; i < stacks_.size (); ++i)
+          computeLevelValue<ComputeJac> (i, config);
       }
 
       template void HierarchicalIterative::computeValue<false>(vectorIn_t config) const;
@@ -616,6 +913,10 @@ namespace hpp {
       void HierarchicalIterative::computeSaturation (vectorIn_t config) const
       {
         bool applySaturate = saturate_->saturate (config, qSat_, saturation_);
+        if (activeBoundSteps_) {
+          computeActiveBounds (applySaturate);
+          return;
+        }
         if (!applySaturate) return;
 
         reducedSaturation_ = freeVariables_.rview (saturation_);
@@ -631,12 +932,57 @@ namespace hpp {
           vector_t error = d.activeRowsOfJ.keepRows().rview(d.error);
           tmpSat_ = (reducedSaturation_.cast<value_type>().cwiseProduct
                      (d.reducedJ.transpose() * error).array() < 0);
+          if (tmpSat_.any()) {
+            // Decompositions computed with saturated columns must not be
+            // reused.
+            invalidateFactorizations (0);
+            lastConfig_.resize (0);
+          }
           for (size_type j = 0; j < tmpSat_.size(); ++j)
             if (tmpSat_[j])
               d.reducedJ.col(j).setZero();
         }
       }
 
+      void HierarchicalIterative::computeActiveBounds (bool saturated) const
+      {
+        const size_type n (freeVariables_.nbIndices ());
+        ArrayXb active (ArrayXb::Constant (n, false));
+        if (saturated) {
+          reducedSaturation_ = freeVariables_.rview (saturation_);
+          // Gradient of the squared error and previous step, restricted to
+          // the free variables.
+          vector_t gradient (vector_t::Zero (n));
+          for (std::size_t i = 0; i < stacks_.size (); ++i) {
+            const Data& d = datas_[i];
+            vector_t error = d.activeRowsOfJ.keepRows().rview(d.error);
+            gradient.noalias () += d.reducedJ.transpose () * error;
+          }
+          const vector_t step (freeVariables_.rview (dq_));
+          const bool previous (activeBounds_.size () == n);
+          for (size_type j = 0; j < n; ++j) {
+            const value_type s (reducedSaturation_[j]);
+            if (s == 0) continue;
+            if (previous && activeBounds_[j])
+              active[j] = (s * gradient[j] <= 0);
+            else
+              active[j] = (s * gradient[j] < 0 || s * step[j] > 0);
+          }
+        }
+        if (activeBounds_.size () != n || (active != activeBounds_).any ()) {
+          // Decompositions computed with other columns must not be reused.
+          invalidateFactorizations (0);
+          lastConfig_.resize (0);
+          activeBounds_ = active;
+        }
+        if (!active.any ()) return;
+        for (std::size_t i = 0; i < stacks_.size (); ++i) {
+          Data& d = datas_[i];
+          for (size_type j = 0; j < n; ++j)
+            if (active[j]) d.reducedJ.col(j).setZero();
+        }
+      }
+
       void HierarchicalIterative::getValue (vectorOut_t v) const
       {
         size_type row = 0;
@@ -659,6 +1005,39 @@ namespace hpp {
         assert (J.rows() == row);
       }
 
+      void HierarchicalIterative::getJacobian (matrixOut_t J) const
+      {
+        size_type row = 0;
+        for (std::size_t i = 0; i < datas_.size(); ++i) {
+          const Data& d = datas_[i];
+          J.middleRows(row, d.jacobian.rows()) = d.jacobian;
+          row += d.jacobian.rows();
+        }
+        assert (J.rows() == row);
+      }
+
+      bool HierarchicalIterative::isLevelSatisfied (std::size_t iStack) const
+      {
+        const ImplicitConstraintSet::Implicits_t constraints
+          (stacks_ [iStack].constraints ());
+        const Data& d = datas_[iStack];
+        size_type iv = 0;
+        for (std::size_t j = 0; j < constraints.size(); ++j) {
+          size_type nv (constraints [j]->function ().outputDerivativeSize ());
+          if (d.error.segment(iv, nv).squaredNorm() >= squaredErrorThreshold_)
+            return false;
+          iv += nv;
+        }
+        return true;
+      }
+
+      void HierarchicalIterative::invalidateFactorizations
+      (std::size_t iStack) const
+      {
+        for (std::size_t i = iStack; i < datas_.size (); ++i)
+          datas_[i].factorizedAt.resize (0);
+      }
+
       void HierarchicalIterative::computeError () const
       {
         const std::size_t end = (lastIsOptional_ ? stacks_.size() - 1 :
@@ -681,11 +1060,31 @@ namespace hpp {
       bool HierarchicalIterative::integrate
       (vectorIn_t from, vectorIn_t velocity, vectorOut_t result) const
       {
-        typedef pinocchio::LiegroupElementRef LgeRef_t;
-        result = from;
-        LgeRef_t M(result, configSpace_);
-        M += velocity;
-        return saturate_->saturate (result, result, saturation_);
+        const std::vector<pinocchio::LiegroupType>& types
+          (configSpace_->liegroupTypes ());
+        if (result.data () != from.data ()) result = from;
+        integratedIntervals_.clear ();
+        for (std::vector<Component>::const_iterator c (components_.begin ());
+             c != components_.end (); ++c) {
+          // Variables that are not free are usually left unchanged.
+          if (!c->selected && velocity.segment (c->iv, c->nv).isZero (0))
+            continue;
+          if (c->vectorSpace)
+            result.segment (c->iq, c->nq) += velocity.segment (c->iv, c->nv);
+          else
+            internal::componentIntegrate
+              (types[c->rank], result.segment (c->iq, c->nq),
+               velocity.segment (c->iv, c->nv),
+               result.segment (c->iq, c->nq));
+          if (!integratedIntervals_.empty () &&
+              integratedIntervals_.back ().first +
+              integratedIntervals_.back ().second == c->iq)
+            integratedIntervals_.back ().second += c->nq;
+          else
+            integratedIntervals_.push_back (segment_t (c->iq, c->nq));
+        }
+        return saturate_->saturateIntervals (result, result, saturation_,
+                                             integratedIntervals_);
       }
 
       void HierarchicalIterative::residualError (vectorOut_t error) const
@@ -726,17 +1125,38 @@ namespace hpp {
           dq_.setZero();
           return;
         }
+        const bool scaled (scalingPeriod_ > 0);
+        if (scaled) {
+          if (scalingAge_ % scalingPeriod_ == 0) {
+            computeScaling ();
+            invalidateFactorizations (0);
+          }
+          ++scalingAge_;
+          for (std::size_t i = 0; i < stacks_.size (); ++i) {
+            Data& d = datas_[i];
+            d.scaledJ.noalias() = d.rowScaling.asDiagonal() * d.reducedJ
+              * columnScaling_.asDiagonal();
+          }
+        }
+        // Far from the solution, decompositions are computed in single
+        // precision.
+        const bool single (mixedPrecisionFactor_ > 0 && squaredNorm_ >
+                           mixedPrecisionFactor_ * squaredErrorThreshold_);
+        // Damping of the last level
+        const value_type lastDamping (lastIsOptional_ ? damping_ : 0);
         vector_t err;
         if (stacks_.size() == 1) { // one level only
           Data& d = datas_[0];
-          d.svd.compute (d.reducedJ);
-          HPP_DEBUG_SVDCHECK (d.svd);
+          const matrix_t& J (scaled ? d.scaledJ : d.reducedJ);
+          factorize (d, J, single);
+          if (!single) HPP_DEBUG_SVDCHECK (d.svd);
           // TODO Eigen::JacobiSVD does a dynamic allocation here.
           err = d.activeRowsOfJ.keepRows().rview(- d.error);
-          dqSmall_ = d.svd.solve (err);
-          d.maxRank = std::max(d.maxRank, d.svd.rank());
+          if (scaled) err.array() *= d.rowScaling.array();
+          dqSmall_ = solveLeastSquares (d, J, err, lastDamping);
+          d.maxRank = std::max(d.maxRank, rank (d));
           if (d.maxRank > 0)
-            sigma_ = std::min(sigma_, d.svd.singularValues()[d.maxRank - 1]);
+            sigma_ = std::min(sigma_, singularValue (d, d.maxRank - 1));
         } else {
           // dq = dQ_0 + P_0 * v_1
           // f_1(q+dq) = f_1(q) + J_1 * dQ_0 + M_1 * v_1
@@ -748,57 +1168,126 @@ namespace hpp {
           // dQ_1 = dQ_0 + P_0 * M+_1 * (-f_1(q) - J_1 * dQ_1)
           //  P_1 = P_0 * K_1
           matrix_t* projector = NULL;
+          // Whether the decompositions of the levels visited so far are
+          // reused. Single precision decompositions are never reused.
+          bool reuse = (refactorizationTolerance_ > 0) && !single;
           for (std::size_t i = 0; i < stacks_.size (); ++i) {
             Data& d = datas_[i];
 
             // TODO: handle case where this is the first element of the stack and it
             // has no functions
             if (d.reducedJ.rows() == 0) continue;
+            const matrix_t& J (scaled ? d.scaledJ : d.reducedJ);
             /// projector is of size numberDof
             bool first = (i == 0);
             bool last = (i == stacks_.size() - 1);
+            if (reuse) {
+              reuse = (d.factorizedAt.size() > 0) &&
+                (d.factorizedAt.size() == lastConfig_.size()) &&
+                ((lastConfig_ - d.factorizedAt).lpNorm<Eigen::Infinity>()
+                 < refactorizationTolerance_) && isLevelSatisfied (i);
+              if (reuse) {
+                // The level is satisfied: its contribution is neglected and
+                // the previous decomposition is kept.
+                ++reusedFactorizations_;
+                if (first) dqSmall_.setZero();
+                const size_type rank = d.svd.rank();
+                if (d.maxRank > 0)
+                  sigma_ = std::min(sigma_, d.svd.singularValues()[d.maxRank - 1]);
+                if (last) break;
+                if (d.svd.matrixV().cols() == rank) break;
+                projector = &d.PK;
+                continue;
+              }
+              // Decompositions of the next levels depend on this one.
+              invalidateFactorizations (i);
+            }
+            if (refactorizationTolerance_ > 0) {
+              if (single) d.factorizedAt.resize (0);
+              else        d.factorizedAt = lastConfig_;
+            }
             if (first) {
               err = d.activeRowsOfJ.keepRows().rview(- d.error);
+              if (scaled) err.array() *= d.rowScaling.array();
               // dq should be zero and projector should be identity
-              d.svd.compute (d.reducedJ);
-              HPP_DEBUG_SVDCHECK (d.svd);
+              factorize (d, J, single);
               // TODO Eigen::JacobiSVD does a dynamic allocation here.
-              dqSmall_ = d.svd.solve (err);
+              dqSmall_ = solveLeastSquares (d, J, err,
+                                            last ? lastDamping : 0);
             } else {
               err = d.activeRowsOfJ.keepRows().rview(- d.error);
-              err.noalias() -= d.reducedJ * dqSmall_;
+              if (scaled) err.array() *= d.rowScaling.array();
+              err.noalias() -= J * dqSmall_;
 
               if (projector == NULL) {
-                d.svd.compute (d.reducedJ);
+                factorize (d, J, single);
                 // TODO Eigen::JacobiSVD does a dynamic allocation here.
-                dqSmall_ += d.svd.solve (err);
+                dqSmall_ += solveLeastSquares (d, J, err,
+                                               last ? lastDamping : 0);
               } else {
-                d.svd.compute (d.reducedJ * *projector);
+                const matrix_t JP (J * *projector);
+                factorize (d, JP, single);
                 // TODO Eigen::JacobiSVD does a dynamic allocation here.
-                dqSmall_ += *projector * d.svd.solve (err);
+                dqSmall_ += *projector * solveLeastSquares
+                  (d, JP, err, last ? lastDamping : 0);
               }
-              HPP_DEBUG_SVDCHECK (d.svd);
             }
+            if (!single) HPP_DEBUG_SVDCHECK (d.svd);
             // Update sigma
-            const size_type rank = d.svd.rank();
-            d.maxRank = std::max(d.maxRank, rank);
+            const size_type r = rank (d);
+            d.maxRank = std::max(d.maxRank, r);
             if (d.maxRank > 0)
-              sigma_ = std::min(sigma_, d.svd.singularValues()[d.maxRank - 1]);
+              sigma_ = std::min(sigma_, singularValue (d, d.maxRank - 1));
 
             if (last) break; // No need to compute projector for next step.
 
-            if (d.svd.matrixV().cols() == rank) break; // The kernel is { 0 }
+            if (J.cols() == r) break; // The kernel is { 0 }
             /// compute projector for next step.
             if (projector == NULL)
-              d.PK.noalias() = getV2<SVD_t> (d.svd, rank);
+              d.PK.noalias() = kernel (d, r);
             else
-              d.PK.noalias() = *projector * getV2<SVD_t> (d.svd, rank);
+              d.PK.noalias() = *projector * kernel (d, r);
             projector = &d.PK;
           }
         }
+        // Map the solution of the scaled problem back to the free variables.
+        if (scaled) dqSmall_.array() *= columnScaling_.array();
         expandDqSmall();
       }
 
+      void HierarchicalIterative::computeScaling () const
+      {
+        static const value_type eps = Eigen::NumTraits<value_type>::epsilon();
+        vector_t colNorm2 (vector_t::Zero (dqSmall_.size()));
+        for (std::size_t i = 0; i < stacks_.size (); ++i) {
+          Data& d = datas_[i];
+          if (d.reducedJ.rows() == 0) continue;
+          // Largest squared row norm of each constraint of the level. Rows
+          // that are not active are set to zero.
+          vector_t rowNorm2 (vector_t::Zero (d.error.size()));
+          d.activeRowsOfJ.keepRows().lview (rowNorm2) =
+            d.reducedJ.rowwise().squaredNorm();
+          vector_t scaling (vector_t::Ones (d.error.size()));
+          const ImplicitConstraintSet::Implicits_t constraints
+            (stacks_ [i].constraints ());
+          size_type iv = 0;
+          for (std::size_t j = 0; j < constraints.size(); ++j) {
+            size_type nv (constraints [j]->function ().outputDerivativeSize ());
+            const value_type n2 (rowNorm2.segment (iv, nv).maxCoeff ());
+            if (n2 > eps)
+              scaling.segment (iv, nv).setConstant (1 / std::sqrt (n2));
+            iv += nv;
+          }
+          d.rowScaling = d.activeRowsOfJ.keepRows().rview (scaling);
+          colNorm2 += (d.rowScaling.asDiagonal() * d.reducedJ)
+            .colwise().squaredNorm().transpose();
+        }
+        // Columns set to zero (by saturation for instance) are not scaled.
+        for (size_type k = 0; k < colNorm2.size(); ++k)
+          columnScaling_[k] = (colNorm2[k] > eps) ?
+            1 / std::sqrt (colNorm2[k]) : 1;
+      }
+
       void HierarchicalIterative::expandDqSmall () const
       {
         Eigen::MatrixBlockView<vector_t, Eigen::Dynamic, 1, false, true>
@@ -849,6 +1338,8 @@ namespace hpp {
       template HierarchicalIterative::Status HierarchicalIterative::solve
       (vectorOut_t arg, lineSearch::Backtracking   lineSearch) const;
       template HierarchicalIterative::Status HierarchicalIterative::solve
+      (vectorOut_t arg, lineSearch::Interpolation  lineSearch) const;
+      template HierarchicalIterative::Status HierarchicalIterative::solve
       (vectorOut_t arg, lineSearch::FixedSequence  lineSearch) const;
       template HierarchicalIterative::Status HierarchicalIterative::solve
       (vectorOut_t arg, lineSearch::ErrorNormBased lineSearch) const;
@@ -864,12 +1355,27 @@ namespace hpp {
         ar & BOOST_SERIALIZATION_NVP(lastIsOptional_);
         ar & BOOST_SERIALIZATION_NVP(saturate_);
 
+        scalingPeriod_ = 0;
+        scalingAge_ = 0;
+        refactorizationTolerance_ = 0;
+        mixedPrecisionFactor_ = 0;
+        damping_ = 0;
+        activeBoundSteps_ = false;
+        iterations_ = 0;
+        reusedFactorizations_ = 0;
+        recorder_.reset ();
+        snapshot_.valid = false;
+        storeSnapshot_ = false;
+        snapshotJacobian_ = false;
+        kinematicMask_.resize (0);
+        parallelEvaluation_ = false;
         saturation_.resize(configSpace_->nq());
         qSat_.resize(configSpace_->nq ());
         OM_.resize(configSpace_->nv ());
         OP_.resize(configSpace_->nv ());
         // Initialize freeVariables_ to all indices.
         freeVariables_.addRow (0, configSpace_->nv ());
+        updateComponents ();
 
         NumericalConstraints_t constraints;
         std::vector<std::size_t> priorities;
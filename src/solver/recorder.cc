@@ -0,0 +1,358 @@
+// Copyright (c) 2026, CNRS
+//
+// This file is part of hpp-constraints.
+// hpp-constraints is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-constraints is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-constraints. If not, see <http://www.gnu.org/licenses/>.
+
+#include <hpp/constraints/solver/recorder.hh>
+
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <boost/cstdint.hpp>
+#include <boost/serialization/nvp.hpp>
+
+#include <hpp/util/serialization.hh>
+
+#include <hpp/pinocchio/device.hh>
+#include <hpp/pinocchio/serialization.hh>
+
+#include <hpp/constraints/solver/by-substitution.hh>
+#include <hpp/constraints/solver/impl/by-substitution.hh>
+#include <hpp/constraints/solver/impl/hierarchical-iterative.hh>
+
+namespace hpp {
+  namespace constraints {
+    namespace solver {
+      namespace {
+        // Each record starts with this tag followed by the format version.
+        const char recordTag[] = "HPPSOLVE";
+        const std::size_t recordTagSize = sizeof (recordTag) - 1;
+        const boost::uint8_t recordVersion = 2;
+
+        template <typename T> void writeValue (std::ostream& os, const T& v)
+        {
+          os.write (reinterpret_cast <const char*> (&v), sizeof (T));
+        }
+
+        void writeString (std::ostream& os, const std::string& s)
+        {
+          writeValue (os, (boost::uint64_t) s.size ());
+          os.write (s.data (), (std::streamsize) s.size ());
+        }
+
+        void writeVector (std::ostream& os, vectorIn_t v)
+        {
+          writeValue (os, (boost::uint64_t) v.size ());
+          for (size_type i = 0; i < v.size (); ++i) writeValue (os, v [i]);
+        }
+
+        template <typename T> void readValue (std::istream& is, T& v)
+        {
+          is.read (reinterpret_cast <char*> (&v), sizeof (T));
+          if (!is) throw std::runtime_error ("Truncated solver record.");
+        }
+
+        void readString (std::istream& is, std::string& s)
+        {
+          boost::uint64_t n; readValue (is, n);
+          s.resize ((std::size_t) n);
+          if (n > 0) is.read (&s [0], (std::streamsize) n);
+          if (!is) throw std::runtime_error ("Truncated solver record.");
+        }
+
+        void readVector (std::istream& is, vector_t& v)
+        {
+          boost::uint64_t n; readValue (is, n);
+          v.resize ((size_type) n);
+          for (size_type i = 0; i < v.size (); ++i) readValue (is, v [i]);
+        }
+
+        // Get the recorded parameters of a line search
+        void checkParameters (const Recorder::Record& record, size_type n)
+        {
+          if (record.lineSearchParameters.size () != n)
+            throw std::runtime_error ("Invalid line search parameters in "
+                                      "solver record.");
+        }
+
+        void setParameters (const Recorder::Record& record,
+                            lineSearch::Backtracking& ls)
+        {
+          checkParameters (record, 3);
+          const vector_t& p (record.lineSearchParameters);
+          ls.c = p [0]; ls.tau = p [1]; ls.smallAlpha = p [2];
+        }
+
+        void setParameters (const Recorder::Record& record,
+                            lineSearch::Interpolation& ls)
+        {
+          checkParameters (record, 5);
+          const vector_t& p (record.lineSearchParameters);
+          ls.c = p [0]; ls.tau = p [1]; ls.smallAlpha = p [2];
+          ls.sigmaLow = p [3]; ls.sigmaHigh = p [4];
+        }
+
+        void setParameters (const Recorder::Record& record,
+                            lineSearch::FixedSequence& ls)
+        {
+          checkParameters (record, 3);
+          const vector_t& p (record.lineSearchParameters);
+          ls.alpha = p [0]; ls.alphaMax = p [1]; ls.K = p [2];
+        }
+
+        void setParameters (const Recorder::Record& record,
+                            lineSearch::ErrorNormBased& ls)
+        {
+          checkParameters (record, 4);
+          const vector_t& p (record.lineSearchParameters);
+          ls.C = p [0]; ls.K = p [1]; ls.a = p [2]; ls.b = p [3];
+        }
+
+        void setParameters (const Recorder::Record&, lineSearch::Constant&)
+        {}
+
+        template <typename LineSearchType>
+        HierarchicalIterative::Status replaySolve
+        (const HierarchicalIterative& solver, const Recorder::Record& record,
+         vectorOut_t arg)
+        {
+          LineSearchType ls;
+          setParameters (record, ls);
+          if (record.bySubstitution)
+            return static_cast <const BySubstitution&> (solver).solve
+              (arg, record.optimize, ls);
+          return solver.solve (arg, ls);
+        }
+      } // namespace
+
+      RecorderPtr_t Recorder::create (std::ostream& os,
+                                      const DevicePtr_t& robot)
+      {
+        return RecorderPtr_t (new Recorder (os, robot));
+      }
+
+      Recorder::Recorder (std::ostream& os, const DevicePtr_t& robot) :
+        os_ (os), robot_ (robot), count_ (0), input_ (),
+        lineSearch_ (OTHER), lineSearchParameters_ (), optimize_ (false),
+        start_ ()
+      {
+        if (!robot_)
+          throw std::invalid_argument ("Recorder requires a robot.");
+      }
+
+      void Recorder::lineSearchParameters (const lineSearch::Backtracking& ls,
+                                           vector_t& parameters)
+      {
+        parameters.resize (3);
+        parameters << ls.c, ls.tau, ls.smallAlpha;
+      }
+
+      void Recorder::lineSearchParameters
+      (const lineSearch::Interpolation& ls, vector_t& parameters)
+      {
+        parameters.resize (5);
+        parameters << ls.c, ls.tau, ls.smallAlpha, ls.sigmaLow, ls.sigmaHigh;
+      }
+
+      void Recorder::lineSearchParameters
+      (const lineSearch::FixedSequence& ls, vector_t& parameters)
+      {
+        parameters.resize (3);
+        parameters << ls.alpha, ls.alphaMax, ls.K;
+      }
+
+      void Recorder::lineSearchParameters
+      (const lineSearch::ErrorNormBased& ls, vector_t& parameters)
+      {
+        parameters.resize (4);
+        parameters << ls.C, ls.K, ls.a, ls.b;
+      }
+
+      void Recorder::checkSolver (const HierarchicalIterative& solver)
+      {
+        const BySubstitution* bySubstitution
+          (dynamic_cast <const BySubstitution*> (&solver));
+        if (bySubstitution && bySubstitution->solutionCacheSize () > 0)
+          throw std::logic_error ("Cannot record the calls of a solver with "
+                                  "a solution cache.");
+      }
+
+      void Recorder::stop (const HierarchicalIterative& solver,
+                           vectorIn_t output, Status status)
+      {
+        const boost::posix_time::time_duration duration
+          (boost::posix_time::microsec_clock::universal_time () - start_);
+
+        const BySubstitution* bySubstitution
+          (dynamic_cast <const BySubstitution*> (&solver));
+        std::ostringstream archive;
+        {
+          hpp::serialization::binary_oarchive oa (archive);
+          oa.insert (robot_->name (), robot_.get ());
+          if (bySubstitution)
+            oa << boost::serialization::make_nvp ("solver", *bySubstitution);
+          else
+            oa << boost::serialization::make_nvp ("solver", solver);
+        }
+
+        os_.write (recordTag, (std::streamsize) recordTagSize);
+        writeValue (os_, recordVersion);
+        writeValue (os_, (boost::uint8_t) (bySubstitution != NULL));
+        writeValue (os_, (boost::uint8_t) optimize_);
+        writeValue (os_, (boost::int32_t) lineSearch_);
+        writeVector (os_, lineSearchParameters_);
+        writeString (os_, robot_->name ());
+        writeString (os_, archive.str ());
+        writeValue (os_, (boost::int64_t) solver.automaticScaling ());
+        writeValue (os_, solver.refactorizationTolerance ());
+        writeValue (os_, solver.mixedPrecision ());
+        writeValue (os_, (boost::uint8_t) solver.activeBoundSteps ());
+        writeValue (os_, (boost::uint8_t)
+                    (bySubstitution && bySubstitution->automaticPromotion ()));
+        writeValue (os_, bySubstitution ?
+                    bySubstitution->optimizationTolerance () : value_type (0));
+        writeVector (os_, bySubstitution ? bySubstitution->rightHandSide ()
+                     : solver.rightHandSide ());
+        writeVector (os_, input_);
+        writeVector (os_, output);
+        writeValue (os_, (boost::int32_t) status);
+        writeValue (os_, (boost::int64_t) solver.iterations ());
+        writeValue (os_, (value_type) duration.total_microseconds () * 1e-6);
+        os_.flush ();
+        ++count_;
+      }
+
+      bool Recorder::read (std::istream& is, Record& record)
+      {
+        char tag [recordTagSize];
+        is.read (tag, (std::streamsize) recordTagSize);
+        if (is.gcount () == 0) return false;
+        if (!is || std::memcmp (tag, recordTag, recordTagSize) != 0)
+          throw std::runtime_error ("Invalid solver record.");
+        boost::uint8_t version, bySubstitution, optimize, activeBoundSteps,
+          automaticPromotion;
+        boost::int32_t lineSearch, status;
+        boost::int64_t iterations, automaticScaling;
+        readValue (is, version);
+        if (version != recordVersion) {
+          std::ostringstream oss;
+          oss << "Unsupported solver record version " << (int) version << ".";
+          throw std::runtime_error (oss.str ());
+        }
+        readValue (is, bySubstitution);
+        readValue (is, optimize);
+        readValue (is, lineSearch);
+        readVector (is, record.lineSearchParameters);
+        readString (is, record.robotName);
+        readString (is, record.solver);
+        readValue (is, automaticScaling);
+        readValue (is, record.options.refactorizationTolerance);
+        readValue (is, record.options.mixedPrecision);
+        readValue (is, activeBoundSteps);
+        readValue (is, automaticPromotion);
+        readValue (is, record.options.optimizationTolerance);
+        readVector (is, record.rightHandSide);
+        readVector (is, record.input);
+        readVector (is, record.output);
+        readValue (is, status);
+        readValue (is, iterations);
+        readValue (is, record.time);
+        record.bySubstitution = (bySubstitution != 0);
+        record.optimize = (optimize != 0);
+        record.lineSearch = (LineSearch) lineSearch;
+        record.options.automaticScaling = (size_type) automaticScaling;
+        record.options.activeBoundSteps = (activeBoundSteps != 0);
+        record.options.automaticPromotion = (automaticPromotion != 0);
+        record.status = (Status) status;
+        record.iterations = (size_type) iterations;
+        return true;
+      }
+
+      shared_ptr<HierarchicalIterative> Recorder::solver
+      (const Record& record, const DevicePtr_t& robot)
+      {
+        if (robot->name () != record.robotName)
+          throw std::invalid_argument ("Record was written with robot "
+              + record.robotName + ", not " + robot->name () + ".");
+        std::istringstream archive (record.solver);
+        hpp::serialization::binary_iarchive ia (archive);
+        ia.insert (robot->name (), robot.get ());
+        const Options& options (record.options);
+        shared_ptr<HierarchicalIterative> s;
+        if (record.bySubstitution) {
+          shared_ptr<BySubstitution> bs
+            (new BySubstitution (robot->configSpace ()));
+          // Promotion applies to the constraints added when loading.
+          bs->automaticPromotion (options.automaticPromotion);
+          ia >> boost::serialization::make_nvp ("solver", *bs);
+          bs->optimizationTolerance (options.optimizationTolerance);
+          s = bs;
+        } else {
+          s.reset (new HierarchicalIterative (robot->configSpace ()));
+          ia >> boost::serialization::make_nvp ("solver", *s);
+        }
+        s->automaticScaling (options.automaticScaling);
+        s->refactorizationTolerance (options.refactorizationTolerance);
+        s->mixedPrecision (options.mixedPrecision);
+        s->activeBoundSteps (options.activeBoundSteps);
+        s->rightHandSide (record.rightHandSide);
+        return s;
+      }
+
+      void Recorder::replay (const Record& record, const DevicePtr_t& robot,
+                             Record& result)
+      {
+        shared_ptr<HierarchicalIterative> s (solver (record, robot));
+        result = record;
+        result.output = record.input;
+
+        const boost::posix_time::ptime start
+          (boost::posix_time::microsec_clock::universal_time ());
+        switch (record.lineSearch) {
+          case CONSTANT:
+            result.status = replaySolve <lineSearch::Constant>
+              (*s, record, result.output);
+            break;
+          case BACKTRACKING:
+            result.status = replaySolve <lineSearch::Backtracking>
+              (*s, record, result.output);
+            break;
+          case INTERPOLATION:
+            result.status = replaySolve <lineSearch::Interpolation>
+              (*s, record, result.output);
+            break;
+          case ERROR_NORM_BASED:
+            result.status = replaySolve <lineSearch::ErrorNormBased>
+              (*s, record, result.output);
+            break;
+          case FIXED_SEQUENCE:
+            result.status = replaySolve <lineSearch::FixedSequence>
+              (*s, record, result.output);
+            break;
+          case OTHER:
+          default:
+            result.status = replaySolve <HierarchicalIterative::DefaultLineSearch>
+              (*s, record, result.output);
+            break;
+        }
+        const boost::posix_time::time_duration duration
+          (boost::posix_time::microsec_clock::universal_time () - start);
+        result.iterations = s->iterations ();
+        result.time = (value_type) duration.total_microseconds () * 1e-6;
+      }
+    } // namespace solver
+  } // namespace constraints
+} // namespace hpp
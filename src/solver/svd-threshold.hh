@@ -0,0 +1,24 @@
+// Copyright (c) 2026, CNRS
+//
+// This file is part of hpp-constraints.
+// hpp-constraints is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-constraints is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-constraints. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_CONSTRAINTS_SRC_SOLVER_SVD_THRESHOLD_HH
+#define HPP_CONSTRAINTS_SRC_SOLVER_SVD_THRESHOLD_HH
+
+// Relative threshold below which singular values of the Jacobians of the
+// solvers are considered zero.
+// #define SVD_THRESHOLD Eigen::NumTraits<value_type>::dummy_precision()
+#define SVD_THRESHOLD 1e-8
+
+#endif // HPP_CONSTRAINTS_SRC_SOLVER_SVD_THRESHOLD_HH
@@ -0,0 +1,250 @@
+// Copyright (c) 2026, CNRS
+//
+// This file is part of hpp-constraints.
+// hpp-constraints is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-constraints is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-constraints. If not, see <http://www.gnu.org/licenses/>.
+
+#include <hpp/constraints/task-scheduler.hh>
+
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include <hpp/pinocchio/device.hh>
+
+namespace hpp {
+  namespace constraints {
+    namespace {
+      // Scheduler the loop of which is run by the current thread, and index
+      // of the worker in this loop. Used to detect nested loops.
+      thread_local const TaskScheduler* currentScheduler = NULL;
+      thread_local std::size_t currentWorker = 0;
+
+      // Set the current scheduler and worker of the thread for the lifetime
+      // of the object.
+      struct WorkerScope
+      {
+        WorkerScope (const TaskScheduler* scheduler, std::size_t worker) :
+          scheduler_ (currentScheduler), worker_ (currentWorker)
+        {
+          currentScheduler = scheduler;
+          currentWorker = worker;
+        }
+        ~WorkerScope ()
+        {
+          currentScheduler = scheduler_;
+          currentWorker = worker_;
+        }
+        const TaskScheduler* scheduler_;
+        std::size_t worker_;
+      }; // struct WorkerScope
+
+      // First index of chunk k of [0, n) split into m chunks
+      inline size_type chunkBegin (size_type n, std::size_t k, std::size_t m)
+      {
+        return (n * (size_type) k) / (size_type) m;
+      }
+    } // namespace
+
+    /// Body of a loop split into chunks of contiguous indices
+    struct TaskScheduler::Chunks
+    {
+      virtual ~Chunks () {}
+      virtual void run (size_type begin, size_type end,
+                        std::size_t worker) = 0;
+    }; // struct TaskScheduler::Chunks
+
+    namespace {
+      struct LoopChunks : TaskScheduler::Chunks
+      {
+        LoopChunks (TaskScheduler::Loop& loop) : loop_ (loop) {}
+        void run (size_type begin, size_type end, std::size_t worker)
+        {
+          for (size_type i = begin; i < end; ++i) loop_.run (i, worker);
+        }
+        TaskScheduler::Loop& loop_;
+      }; // struct LoopChunks
+
+      struct DeviceLoopChunks : TaskScheduler::Chunks
+      {
+        DeviceLoopChunks (TaskScheduler::DeviceLoop& loop,
+                          const DevicePtr_t& robot) :
+          loop_ (loop), robot_ (robot)
+        {}
+        void run (size_type begin, size_type end, std::size_t)
+        {
+          if (begin == end) return;
+          pinocchio::DeviceSync device (robot_);
+          for (size_type i = begin; i < end; ++i) loop_.run (i, device);
+        }
+        TaskScheduler::DeviceLoop& loop_;
+        const DevicePtr_t& robot_;
+      }; // struct DeviceLoopChunks
+    } // namespace
+
+    /// Threads running the chunks 1 to numberWorkers - 1 of the loops
+    struct TaskScheduler::Pool
+    {
+      Pool (const TaskScheduler* scheduler, std::size_t numberThreads) :
+        scheduler (scheduler), chunks (NULL), n (0), numberWorkers (0),
+        generation (0), remaining (0), stop (false)
+      {
+        for (std::size_t i = 0; i < numberThreads; ++i)
+          threads.push_back (std::thread (&Pool::work, this, i + 1));
+      }
+
+      ~Pool ()
+      {
+        {
+          std::unique_lock <std::mutex> lock (mutex);
+          stop = true;
+        }
+        start.notify_all ();
+        for (std::size_t i = 0; i < threads.size (); ++i) threads [i].join ();
+      }
+
+      // Run chunk k of the current loop and store its exception, if any.
+      void runChunk (std::size_t k)
+      {
+        WorkerScope scope (scheduler, k);
+        try {
+          chunks->run (chunkBegin (n, k, numberWorkers),
+                       chunkBegin (n, k + 1, numberWorkers), k);
+        } catch (...) {
+          errors [k] = std::current_exception ();
+        }
+      }
+
+      void work (std::size_t k)
+      {
+        std::size_t seen = 0;
+        while (true) {
+          {
+            std::unique_lock <std::mutex> lock (mutex);
+            while (!stop && generation == seen) start.wait (lock);
+            if (stop) return;
+            seen = generation;
+            if (k >= numberWorkers) continue;
+          }
+          runChunk (k);
+          std::unique_lock <std::mutex> lock (mutex);
+          if (--remaining == 0) done.notify_one ();
+        }
+      }
+
+      // Run a loop. Chunk 0 is run by the calling thread.
+      void run (size_type size, Chunks& c, std::size_t m)
+      {
+        assert (m <= threads.size () + 1);
+        errors.assign (m, std::exception_ptr ());
+        {
+          std::unique_lock <std::mutex> lock (mutex);
+          chunks = &c; n = size; numberWorkers = m; remaining = m - 1;
+          ++generation;
+        }
+        start.notify_all ();
+        runChunk (0);
+        {
+          std::unique_lock <std::mutex> lock (mutex);
+          while (remaining > 0) done.wait (lock);
+          chunks = NULL;
+        }
+        for (std::size_t k = 0; k < errors.size (); ++k)
+          if (errors [k]) std::rethrow_exception (errors [k]);
+      }
+
+      const TaskScheduler* scheduler;
+      std::vector <std::thread> threads;
+      // Held while a loop runs
+      std::mutex busy;
+      std::mutex mutex;
+      std::condition_variable start, done;
+      Chunks* chunks;
+      size_type n;
+      std::size_t numberWorkers, generation, remaining;
+      bool stop;
+      std::vector <std::exception_ptr> errors;
+    }; // struct TaskScheduler::Pool
+
+    TaskScheduler& TaskScheduler::global ()
+    {
+      static TaskScheduler scheduler;
+      return scheduler;
+    }
+
+    TaskScheduler::TaskScheduler (std::size_t n) :
+      numberWorkers_ (1), pool_ (NULL)
+    {
+      numberWorkers (n);
+    }
+
+    TaskScheduler::~TaskScheduler ()
+    {
+      delete pool_;
+    }
+
+    void TaskScheduler::numberWorkers (std::size_t n)
+    {
+      // The running loop would never end.
+      if (currentScheduler == this)
+        throw std::logic_error ("TaskScheduler::numberWorkers cannot be "
+                                "called from a task of the scheduler.");
+      if (n == 0) n = std::max (std::thread::hardware_concurrency (), 1u);
+      if (pool_) {
+        // Wait for the running loop.
+        { std::unique_lock <std::mutex> lock (pool_->busy); }
+        delete pool_;
+        pool_ = NULL;
+      }
+      numberWorkers_ = n;
+      if (n > 1) pool_ = new Pool (this, n - 1);
+    }
+
+    void TaskScheduler::parallelFor (size_type n, Loop& loop)
+    {
+      LoopChunks chunks (loop);
+      run (n, chunks, numberWorkers_);
+    }
+
+    void TaskScheduler::parallelFor (size_type n, DeviceLoop& loop,
+                                     const DevicePtr_t& robot)
+    {
+      DeviceLoopChunks chunks (loop, robot);
+      run (n, chunks, std::min (numberWorkers_,
+                                (std::size_t) robot->numberDeviceData ()));
+    }
+
+    void TaskScheduler::run (size_type n, Chunks& chunks,
+                             std::size_t numberWorkers)
+    {
+      if (n <= 0) return;
+      // Nested loop: run it in the worker of the enclosing loop.
+      if (currentScheduler == this) {
+        chunks.run (0, n, currentWorker);
+        return;
+      }
+      if (numberWorkers <= 1 || n == 1) {
+        WorkerScope scope (this, 0);
+        chunks.run (0, n, 0);
+        return;
+      }
+      assert (pool_);
+      std::unique_lock <std::mutex> lock (pool_->busy);
+      pool_->run (n, chunks,
+                  std::min (numberWorkers, (std::size_t) n));
+    }
+  } // namespace constraints
+} // namespace hpp
@@ -18,6 +18,9 @@
 
 #include <pinocchio/fwd.hpp>
 
+#include <cmath>
+#include <limits>
+
 #include <boost/test/included/unit_test.hpp>
 
 #include "hpp/constraints/convex-shape.hh"
@@ -101,3 +104,68 @@ BOOST_AUTO_TEST_CASE (distance)
   checkDistance(t, vector3_t(1, 1, 0), -1);
   checkDistance(t, vector3_t(0, 1, 0),  0);
 }
+
+// Previous implementation of ConvexShape::distanceLocal, edge by edge.
+value_type referenceDistance (const ConvexShape& t, const vector3_t& a)
+{
+  const value_type inf = std::numeric_limits<value_type>::infinity();
+  value_type minPosDist = inf, maxNegDist = - inf;
+  bool outside = false;
+  for (std::size_t i = 0; i < t.shapeDimension_; ++i) {
+    const vector3_t w (a - t.Pts_[i]), v (t.Us_[i]), u (t.Ns_[i]);
+    const value_type c2 (t.Ls_[i]), c1 (v.dot (w));
+    value_type d;
+    if (c1 <= 0)
+      d = (u.dot (w) > 0)?(w.norm()):(- w.norm());
+    else if (c2 <= c1)
+      d = (u.dot (w) > 0)?((w-c2*v).norm()):(-(w-c2*v).norm());
+    else
+      d = u.dot (w);
+    if (d > 0) {
+      outside = true;
+      if (d < minPosDist) minPosDist = d;
+    }
+    if (d <= 0 && d > maxNegDist) maxNegDist = d;
+  }
+  if (outside) return minPosDist;
+  return maxNegDist;
+}
+
+// Previous implementation of ConvexShape::isInsideLocal, edge by edge.
+bool referenceIsInside (const ConvexShape& t, const vector3_t& a)
+{
+  for (std::size_t i = 0; i < t.shapeDimension_; ++i) {
+    if (t.Ns_[i].dot (a - t.Pts_[i]) > 0)
+      return false;
+  }
+  return true;
+}
+
+BOOST_AUTO_TEST_CASE (polygons)
+{
+  // Regular polygons with less and more edges than EdgeBlockSize
+  for (std::size_t n : {5, 6, 16, 24, 40}) {
+    std::vector <vector3_t> pts (n);
+    for (std::size_t i = 0; i < n; ++i) {
+      const value_type theta (2 * M_PI * (value_type) i / (value_type) n);
+      pts [i] = vector3_t (std::cos (theta), std::sin (theta), 0);
+    }
+    // The edge blocks follow copies and reversed shapes.
+    std::vector <ConvexShape> shapes (2, ConvexShape (pts));
+    shapes [1].reverse ();
+    for (std::size_t k = 0; k < shapes.size (); ++k) {
+      const ConvexShape& t (shapes [k]);
+      for (int i = 0; i < 100; ++i) {
+        vector3_t a (vector3_t::Random () * 1.5);
+        a [2] = 0;
+        // The blocks may sum the coordinates in another order than the
+        // vector3_t dot products.
+        BOOST_CHECK_SMALL (t.distanceLocal (a) - referenceDistance (t, a),
+                           1e-12);
+        // Points at less than rounding errors from an edge are not tested.
+        if (std::abs (referenceDistance (t, a)) > 1e-12)
+          BOOST_CHECK_EQUAL (t.isInsideLocal (a), referenceIsInside (t, a));
+      }
+    }
+  }
+}
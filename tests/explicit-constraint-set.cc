@@ -33,9 +33,11 @@
 #include <hpp/pinocchio/urdf/util.hh>
 
 #include <hpp/constraints/affine-function.hh>
+#include <hpp/constraints/differentiable-function-set.hh>
 #include <hpp/constraints/explicit-constraint-set.hh>
 #include <hpp/constraints/generic-transformation.hh>
 #include <hpp/constraints/symbolic-calculus.hh>
+#include <hpp/constraints/task-scheduler.hh>
 
 #include <../tests/util.hh>
 
@@ -74,6 +76,8 @@ using hpp::constraints::Configuration_t;
 using hpp::constraints::value_type;
 using hpp::constraints::Equality;
 using hpp::constraints::ComparisonTypes_t;
+using hpp::constraints::DifferentiableFunctionSet;
+using hpp::constraints::TaskScheduler;
 using hpp::constraints::LockedJoint;
 using hpp::constraints::LockedJointPtr_t;
 using hpp::constraints::EqualToZero;
@@ -243,6 +247,25 @@ class ExplicitTransformation : public DifferentiableFunction
 };
 
 typedef hpp::shared_ptr<TestFunction> TestFunctionPtr_t;
+
+// TestFunction that counts its evaluations
+class CountingFunction : public TestFunction
+{
+  public:
+    mutable std::size_t count;
+
+    CountingFunction(size_type idxIn, size_type idxOut, size_type length)
+      : TestFunction (idxIn, idxOut, length), count (0)
+    {}
+
+  private:
+    void impl_compute (LiegroupElementRef y, vectorIn_t arg) const
+    {
+      ++count;
+      y.vector () = arg;
+    }
+}; // class CountingFunction
+typedef hpp::shared_ptr<CountingFunction> CountingFunctionPtr_t;
 typedef hpp::shared_ptr<ExplicitTransformation> ExplicitTransformationPtr_t;
 
 template <int N>
@@ -611,6 +634,190 @@ BOOST_AUTO_TEST_CASE(locked_joints)
   }
 }
 
+BOOST_AUTO_TEST_CASE(batched_locked_joints)
+{
+  DevicePtr_t device (makeDevice (HumanoidSimple));
+  BOOST_REQUIRE (device);
+
+  JointPtr_t ee1 = device->getJointByName ("lleg5_joint"),
+             ee2 = device->getJointByName ("rleg5_joint"),
+             ee3 = device->getJointByName ("rleg4_joint");
+  TestFunctionPtr_t t1 (new TestFunction (ee1->rankInConfiguration(),
+                                          ee2->rankInConfiguration(), 1));
+
+  // Lock joints ee3, ee1 and the joint of ee1 and ee3, in this order.
+  std::vector<LockedJointPtr_t> locked;
+  locked.push_back (LockedJoint::create
+                    (ee3, ee3->configurationSpace ()->neutral ()));
+  locked.push_back (LockedJoint::create
+                    (ee1, ee1->configurationSpace ()->neutral ()));
+  JointPtr_t ee4 = ee1->parentJoint ();
+  locked.push_back (LockedJoint::create
+                    (ee4, ee4->configurationSpace ()->neutral ()));
+
+  ExplicitConstraintSet expression (device->configSpace ());
+  // t1 depends on ee1, which is locked after.
+  ExplicitPtr_t constraint (Explicit::create
+    (device->configSpace (), t1, t1->inArg().indices (),
+     t1->outArg().indices (), t1->inDer().indices (),
+     t1->outDer().indices ()));
+  BOOST_CHECK (expression.add (constraint) >= 0);
+  for (std::size_t i = 0; i < locked.size (); ++i)
+    BOOST_CHECK (expression.add (locked[i]) >= 0);
+
+  Configuration_t qrand = ::pinocchio::randomConfiguration(device->model());
+  BOOST_CHECK(expression.solve(qrand));
+  BOOST_CHECK(expression.isSatisfied(qrand));
+  BOOST_CHECK_EQUAL(qrand[ee1->rankInConfiguration()], 0);
+  BOOST_CHECK_EQUAL(qrand[ee2->rankInConfiguration()], 0);
+  BOOST_CHECK_EQUAL(qrand[ee3->rankInConfiguration()], 0);
+  BOOST_CHECK_EQUAL(qrand[ee4->rankInConfiguration()], 0);
+
+  // Per joint right hand side.
+  expression.rightHandSide(locked[1], vector_t::Constant(1, .3));
+  expression.rightHandSide(locked[0], vector_t::Constant(1, -.2));
+  vector_t rhs (1);
+  BOOST_CHECK(expression.getRightHandSide(locked[1], rhs));
+  BOOST_CHECK_EQUAL(rhs[0], .3);
+  BOOST_CHECK(expression.solve(qrand));
+  BOOST_CHECK(expression.isSatisfied(qrand));
+  BOOST_CHECK_EQUAL(qrand[ee1->rankInConfiguration()], .3);
+  BOOST_CHECK_EQUAL(qrand[ee2->rankInConfiguration()], .3);
+  BOOST_CHECK_EQUAL(qrand[ee3->rankInConfiguration()], -.2);
+  BOOST_CHECK_EQUAL(qrand[ee4->rankInConfiguration()], 0);
+
+  // Right hand side from a configuration.
+  Configuration_t q = ::pinocchio::randomConfiguration(device->model());
+  expression.rightHandSideFromInput(q);
+  qrand = ::pinocchio::randomConfiguration(device->model());
+  BOOST_CHECK(expression.solve(qrand));
+  BOOST_CHECK(expression.isSatisfied(qrand));
+  BOOST_CHECK_EQUAL(qrand[ee1->rankInConfiguration()],
+                    q[ee1->rankInConfiguration()]);
+  BOOST_CHECK_EQUAL(qrand[ee3->rankInConfiguration()],
+                    q[ee3->rankInConfiguration()]);
+  BOOST_CHECK_EQUAL(qrand[ee4->rankInConfiguration()],
+                    q[ee4->rankInConfiguration()]);
+
+  // Rows of the locked joints in the Jacobian are zero.
+  matrix_t jacobian (device->numberDof(), device->numberDof());
+  expression.jacobian(jacobian, qrand);
+  BOOST_CHECK(jacobian.row(ee1->rankInVelocity()).isZero());
+  BOOST_CHECK(jacobian.row(ee3->rankInVelocity()).isZero());
+  BOOST_CHECK(jacobian.row(ee4->rankInVelocity()).isZero());
+}
+
+BOOST_AUTO_TEST_CASE(solved_constraints)
+{
+  DevicePtr_t device (makeDevice (HumanoidSimple));
+  BOOST_REQUIRE (device);
+
+  JointPtr_t ee1 = device->getJointByName ("lleg5_joint"),
+             ee2 = device->getJointByName ("rleg5_joint"),
+             ee3 = device->getJointByName ("rleg4_joint");
+  CountingFunctionPtr_t f (new CountingFunction (ee1->rankInConfiguration(),
+                                                 ee2->rankInConfiguration(), 1));
+  LockedJointPtr_t locked (LockedJoint::create
+                           (ee3, ee3->configurationSpace ()->neutral ()));
+
+  ExplicitConstraintSet expression (device->configSpace ());
+  ExplicitPtr_t constraint (Explicit::create
+    (device->configSpace (), f, f->inArg().indices (),
+     f->outArg().indices (), f->inDer().indices (),
+     f->outDer().indices ()));
+  BOOST_CHECK (expression.add (constraint) >= 0);
+  BOOST_CHECK (expression.add (locked) >= 0);
+
+  Configuration_t q = ::pinocchio::randomConfiguration(device->model());
+  vector_t error (expression.errorSize ());
+  bool found;
+  BOOST_CHECK(!expression.isSatisfied(q));
+  BOOST_CHECK(expression.solve(q));
+  std::size_t count (f->count);
+
+  // Configuration computed by solve: constraints are not evaluated.
+  BOOST_CHECK(expression.isSatisfied(q, error));
+  BOOST_CHECK(error.isZero());
+  vector_t e (1);
+  BOOST_CHECK(expression.isConstraintSatisfied (constraint, q, e, found));
+  BOOST_CHECK(found);
+  BOOST_CHECK_EQUAL(f->count, count);
+
+  // Modified input variable
+  Configuration_t q1 (q);
+  q1[ee1->rankInConfiguration()] += .1;
+  BOOST_CHECK(!expression.isSatisfied(q1));
+  BOOST_CHECK(!expression.isConstraintSatisfied (constraint, q1, e, found));
+  BOOST_CHECK_EQUAL(f->count, count + 2);
+
+  // Modified output variables
+  q1 = q;
+  q1[ee2->rankInConfiguration()] += .1;
+  BOOST_CHECK(!expression.isSatisfied(q1));
+  q1 = q;
+  q1[ee3->rankInConfiguration()] += .1;
+  BOOST_CHECK(!expression.isSatisfied(q1));
+
+  // Modified right hand side
+  expression.rightHandSide(locked, vector_t::Constant(1, .3));
+  BOOST_CHECK(!expression.isSatisfied(q));
+  BOOST_CHECK(expression.solve(q));
+  BOOST_CHECK(expression.isSatisfied(q));
+}
+
+BOOST_AUTO_TEST_CASE(parallel_evaluation)
+{
+  // f0: 0 -> 1, f1: 0 -> 2, f2: 1 -> 3, f3: 2 -> 4, f4: (3, 4) -> 5
+  // f0 and f1, then f2 and f3 are independent.
+  segments_t s[6];
+  for (int i = 0; i < 6; ++i) s[i] = segments_t (1, segment_t (i, 1));
+  const int in[] = { 0, 0, 1, 2 }, out[] = { 1, 2, 3, 4 };
+  ExplicitConstraintSet expression (LiegroupSpace::Rn (6));
+  DifferentiableFunctionSet functions ("functions");
+  for (int i = 0; i < 4; ++i) {
+    AffineFunctionPtr_t f (AffineFunction::create
+                           (matrix_t::Constant (1, 1, i + 2),
+                            vector_t::Constant (1, -i)));
+    BOOST_CHECK (expression.add (Explicit::create
+      (LiegroupSpace::Rn (6), f, s[in[i]], s[out[i]], s[in[i]],
+       s[out[i]])) >= 0);
+  }
+  segments_t in4 (1, segment_t (3, 2));
+  matrix_t J4 (1, 2); J4 << .5, -1.5;
+  AffineFunctionPtr_t f4 (AffineFunction::create (J4));
+  BOOST_CHECK (expression.add (Explicit::create
+    (LiegroupSpace::Rn (6), f4, in4, s[5], in4, s[5])) >= 0);
+  for (int i = 0; i < 3; ++i)
+    functions.add (AffineFunction::create (matrix_t::Random (2, 6),
+                                           vector_t::Random (2)));
+
+  vector_t x (vector_t::Random (6)), serial (x), parallel (x);
+  matrix_t serialJ (6, 6), parallelJ (6, 6);
+  LiegroupElement serialValue (functions.outputSpace ()),
+    parallelValue (functions.outputSpace ());
+  matrix_t serialFJ (6, 6), parallelFJ (6, 6);
+  BOOST_CHECK (expression.solve (serial));
+  expression.jacobian (serialJ, serial);
+  functions.value (serialValue, x);
+  functions.jacobian (serialFJ, x);
+
+  // The results do not depend on the number of workers.
+  TaskScheduler::global ().numberWorkers (4);
+  expression.parallelEvaluation (true);
+  functions.parallelEvaluation (true);
+  BOOST_CHECK (expression.solve (parallel));
+  expression.jacobian (parallelJ, parallel);
+  functions.value (parallelValue, x);
+  functions.jacobian (parallelFJ, x);
+  TaskScheduler::global ().numberWorkers (1);
+
+  BOOST_CHECK_EQUAL (parallel, serial);
+  BOOST_CHECK_EQUAL (parallelJ, serialJ);
+  BOOST_CHECK_EQUAL (parallelValue.vector (), serialValue.vector ());
+  BOOST_CHECK_EQUAL (parallelFJ, serialFJ);
+  BOOST_CHECK_SMALL (serial [5] - .5 * serial [3] + 1.5 * serial [4], 1e-12);
+}
+
 BOOST_AUTO_TEST_CASE(RelativePose)
 {
   const std::string urdf
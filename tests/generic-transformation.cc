@@ -24,6 +24,7 @@
 #include <pinocchio/algorithm/joint-configuration.hpp>
 
 #include <hpp/pinocchio/device.hh>
+#include <hpp/pinocchio/device-sync.hh>
 #include <hpp/pinocchio/joint.hh>
 #include <hpp/pinocchio/joint-collection.hh>
 #include <hpp/pinocchio/configuration.hh>
@@ -32,6 +33,7 @@
 #include <hpp/pinocchio/urdf/util.hh>
 
 #include "hpp/constraints/tools.hh"
+#include "hpp/constraints/forward-kinematics.hh"
 
 #define BOOST_TEST_MODULE hpp_constraints
 #include <boost/test/included/unit_test.hpp>
@@ -189,6 +191,202 @@ BOOST_AUTO_TEST_CASE (multithread) {
   }
 }
 
+BOOST_AUTO_TEST_CASE (partial_kinematics) {
+  DevicePtr_t device = hpp::pinocchio::unittest::makeDevice(
+      hpp::pinocchio::unittest::HumanoidSimple);
+  BOOST_REQUIRE (device);
+  JointPtr_t ee1 = device->getJointByName ("larm6_joint"),
+             ee2 = device->getJointByName ("rleg5_joint");
+  BasicConfigurationShooter cs (device);
+
+  device->currentConfiguration (*cs.shoot ());
+  device->computeForwardKinematics ();
+  Transform3f tf1 (ee1->currentTransformation ());
+  Transform3f tf2 (ee2->currentTransformation ());
+
+  std::vector<DifferentiableFunctionPtr_t> functions;
+  functions.push_back(Transformation::create         ("Transformation"        , device, ee1, tf1)          );
+  functions.push_back(Orientation::create            ("Orientation"           , device, ee2, tf2)          );
+  functions.push_back(RelativeTransformation::create ("RelativeTransformation", device, ee1, ee2, tf1, tf2));
+
+  Configuration_t q1 = *cs.shoot(), q2 = *cs.shoot();
+  for (std::size_t i = 0; i < functions.size(); ++i) {
+    DifferentiableFunctionPtr_t f = functions[i];
+    BOOST_CHECK (!f->activeDerivativeParameters ().all ());
+
+    LiegroupElement v (f->outputSpace()), vp (f->outputSpace());
+    matrix_t J (f->outputDerivativeSize(), f->inputDerivativeSize()),
+             Jp (f->outputDerivativeSize(), f->inputDerivativeSize());
+    f->value    (v, q1);
+    f->jacobian (J, q1);
+
+    // The joints that are not updated keep their placements at q2.
+    device->currentConfiguration (q2);
+    device->computeForwardKinematics ();
+    {
+      PartialKinematics kinematics (f->activeDerivativeParameters ());
+      f->value    (vp, q1);
+      f->jacobian (Jp, q1);
+    }
+    BOOST_CHECK (v.vector ().isApprox (vp.vector ()));
+    BOOST_CHECK (J.isApprox (Jp));
+  }
+}
+
+BOOST_AUTO_TEST_CASE (incremental_kinematics) {
+  DevicePtr_t device = hpp::pinocchio::unittest::makeDevice(
+      hpp::pinocchio::unittest::HumanoidSimple);
+  BOOST_REQUIRE (device);
+  JointPtr_t ee1 = device->getJointByName ("larm6_joint"),
+             ee2 = device->getJointByName ("rleg5_joint");
+  BasicConfigurationShooter cs (device);
+
+  device->currentConfiguration (*cs.shoot ());
+  device->computeForwardKinematics ();
+  Transform3f tf1 (ee1->currentTransformation ());
+  DifferentiableFunctionPtr_t f (Transformation::create
+                                 ("Transformation", device, ee1, tf1));
+  LiegroupElement v (f->outputSpace()), vi (f->outputSpace());
+  matrix_t J (f->outputDerivativeSize(), f->inputDerivativeSize()),
+           Ji (f->outputDerivativeSize(), f->inputDerivativeSize());
+
+  const ArrayXb all (ArrayXb::Constant (device->numberDof (), true));
+  Configuration_t q (*cs.shoot ());
+  for (int k = 0; k < 4; ++k) {
+    // 0: first evaluation, 1: change a joint of another branch,
+    // 2: change a joint of the chain of ee1, 3: evaluation of the data
+    //    at another configuration by the robot.
+    Configuration_t qrand (*cs.shoot ());
+    JointPtr_t joint (k == 1 ? ee2 : ee1);
+    if (k == 1 || k == 2)
+      q.segment (joint->rankInConfiguration (), joint->configSize ()) =
+        qrand.segment (joint->rankInConfiguration (), joint->configSize ());
+    if (k == 3) f->value (vi, qrand);
+    {
+      PartialKinematics kinematics (all);
+      f->value    (vi, q);
+      f->jacobian (Ji, q);
+    }
+    f->value    (v, q);
+    f->jacobian (J, q);
+    BOOST_CHECK (v.vector ().isApprox (vi.vector ()));
+    BOOST_CHECK (J.isApprox (Ji));
+  }
+}
+
+BOOST_AUTO_TEST_CASE (updated_joints) {
+  const hpp::pinocchio::Computation_t flag ((hpp::pinocchio::Computation_t)
+    (hpp::pinocchio::JOINT_POSITION | hpp::pinocchio::JACOBIAN));
+  DevicePtr_t device = hpp::pinocchio::unittest::makeDevice(
+      hpp::pinocchio::unittest::HumanoidSimple);
+  BOOST_REQUIRE (device);
+  device->controlComputation (flag);
+  const hpp::pinocchio::Model& model (device->model ());
+  JointPtr_t ee1 = device->getJointByName ("larm6_joint"),
+             ee2 = device->getJointByName ("rleg5_joint");
+  BasicConfigurationShooter cs (device);
+
+  Configuration_t q (*cs.shoot ()), qrand (*cs.shoot ());
+  device->currentConfiguration (q);
+  device->computeForwardKinematics ();
+  Transform3f tf1 (ee1->currentTransformation ());
+  DifferentiableFunctionPtr_t f (Transformation::create
+                                 ("Transformation", device, ee1, tf1));
+  LiegroupElement v (f->outputSpace());
+  matrix_t J (f->outputDerivativeSize(), f->inputDerivativeSize()),
+           Jref (f->outputDerivativeSize(), f->inputDerivativeSize());
+
+  const ArrayXb all (ArrayXb::Constant (device->numberDof (), true));
+  PartialKinematics kinematics (all);
+  f->jacobian (J, q);
+  BOOST_CHECK_EQUAL (updatedJoints (), (size_type) model.njoints - 1);
+  // Same configuration: no joint is recomputed.
+  f->value (v, q);
+  BOOST_CHECK_EQUAL (updatedJoints (), 0);
+  f->jacobian (J, q);
+  BOOST_CHECK_EQUAL (updatedJoints (), 0);
+  // Only the subtree of a modified joint is recomputed.
+  q.segment (ee2->rankInConfiguration (), ee2->configSize ()) =
+    qrand.segment (ee2->rankInConfiguration (), ee2->configSize ());
+  f->jacobian (J, q);
+  BOOST_CHECK_EQUAL (updatedJoints (),
+                     (size_type) model.subtrees [ee2->index ()].size ());
+
+  // Robots created at the address of a destroyed one do not reuse its
+  // records.
+  for (int k = 0; k < 4; ++k) {
+    device = hpp::pinocchio::unittest::makeDevice(
+        hpp::pinocchio::unittest::HumanoidSimple);
+    device->controlComputation (flag);
+    ee1 = device->getJointByName ("larm6_joint");
+    f = Transformation::create ("Transformation", device, ee1, tf1);
+    device->currentConfiguration (q);
+    device->computeForwardKinematics ();
+    f->jacobian (J, q);
+    BOOST_CHECK_EQUAL (updatedJoints (),
+                       (size_type) device->model ().njoints - 1);
+    {
+      // The whole kinematics is computed.
+      const ArrayXb whole (0);
+      PartialKinematics none (whole);
+      f->jacobian (Jref, q);
+    }
+    BOOST_CHECK (J.isApprox (Jref));
+  }
+}
+
+BOOST_AUTO_TEST_CASE (partial_kinematics_device) {
+  DevicePtr_t device = hpp::pinocchio::unittest::makeDevice(
+      hpp::pinocchio::unittest::HumanoidSimple);
+  BOOST_REQUIRE (device);
+  device->setDimensionExtraConfigSpace (2);
+  const hpp::pinocchio::Model& model (device->model ());
+  JointPtr_t ee1 = device->getJointByName ("larm6_joint"),
+             ee2 = device->getJointByName ("rleg5_joint");
+
+  Configuration_t q1 (device->configSize ()), q2 (device->configSize ());
+  q1.head (model.nq) = ::pinocchio::randomConfiguration (model);
+  q2.head (model.nq) = ::pinocchio::randomConfiguration (model);
+  q1.tail (2).setZero ();
+  q2.tail (2).setOnes ();
+  device->currentConfiguration (q1);
+  device->computeForwardKinematics ();
+  Transform3f tf1 (ee1->currentTransformation ());
+  DifferentiableFunctionPtr_t f (Transformation::create
+                                 ("Transformation", device, ee1, tf1));
+  BOOST_REQUIRE_EQUAL (f->activeDerivativeParameters ().size (),
+                       device->numberDof ());
+
+  // The extra configuration space does not disable the restriction.
+  hpp::pinocchio::DeviceSync sync (device);
+  sync.currentConfiguration (q1);
+  {
+    PartialKinematics kinematics (f->activeDerivativeParameters ());
+    computeForwardKinematics (sync);
+    BOOST_CHECK (updatedJoints () < (size_type) model.njoints - 1);
+  }
+  BOOST_CHECK (sync.data ().oMi [ee1->index ()].isApprox
+               (device->data ().oMi [ee1->index ()]));
+
+  // After a restricted computation, the device computes the joints that
+  // were left out.
+  sync.computeForwardKinematics ();
+  BOOST_CHECK (sync.data ().oMi [ee2->index ()].isApprox
+               (device->data ().oMi [ee2->index ()]));
+  sync.currentConfiguration (q2);
+  {
+    PartialKinematics kinematics (f->activeDerivativeParameters ());
+    computeForwardKinematics (sync);
+  }
+  sync.computeForwardKinematics ();
+  device->currentConfiguration (q2);
+  device->computeForwardKinematics ();
+  BOOST_CHECK (sync.data ().oMi [ee1->index ()].isApprox
+               (device->data ().oMi [ee1->index ()]));
+  BOOST_CHECK (sync.data ().oMi [ee2->index ()].isApprox
+               (device->data ().oMi [ee2->index ()]));
+}
+
 BOOST_AUTO_TEST_CASE (serialization) {
   DevicePtr_t device = hpp::pinocchio::unittest::makeDevice(
       hpp::pinocchio::unittest::HumanoidSimple);
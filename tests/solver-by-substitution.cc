@@ -22,6 +22,7 @@
 #include <hpp/pinocchio/serialization.hh>
 
 #include <hpp/constraints/solver/by-substitution.hh>
+#include <hpp/constraints/solver/recorder.hh>
 #include <hpp/constraints/explicit/relative-pose.hh>
 
 #include <pinocchio/algorithm/joint-configuration.hpp>
@@ -32,6 +33,7 @@
 #include <hpp/pinocchio/simple-device.hh>
 
 #include <hpp/constraints/affine-function.hh>
+#include <hpp/constraints/configuration-constraint.hh>
 #include <hpp/constraints/generic-transformation.hh>
 #include <hpp/pinocchio/liegroup-element.hh>
 #include <hpp/pinocchio/configuration.hh>
@@ -40,6 +42,9 @@
 
 using hpp::constraints::DifferentiableFunction;
 using hpp::constraints::solver::BySubstitution;
+using hpp::constraints::solver::HierarchicalIterative;
+using hpp::constraints::solver::Recorder;
+using hpp::constraints::solver::RecorderPtr_t;
 using hpp::constraints::matrix_t;
 using hpp::constraints::vector_t;
 using hpp::constraints::vectorOut_t;
@@ -60,6 +65,8 @@ using hpp::constraints::Implicit;
 using hpp::constraints::ImplicitPtr_t;
 using hpp::constraints::matrix3_t;
 using hpp::constraints::LiegroupSpace;
+using hpp::constraints::LiegroupSpacePtr_t;
+using hpp::constraints::NumericalConstraints_t;
 using hpp::constraints::JointPtr_t;
 using hpp::constraints::Transformation;
 using hpp::constraints::RelativeTransformation;
@@ -76,9 +83,11 @@ using hpp::constraints::ComparisonTypes_t;
 using hpp::constraints::EqualToZero;
 using hpp::constraints::Equality;
 using hpp::constraints::LockedJoint;
+using hpp::constraints::ConfigurationConstraint;
 using hpp::constraints::solver::lineSearch::Backtracking;
 using hpp::constraints::solver::lineSearch::Constant;
 using hpp::constraints::solver::lineSearch::ErrorNormBased;
+using hpp::constraints::solver::lineSearch::Interpolation;
 using hpp::constraints::solver::lineSearch::FixedSequence;
 using hpp::pinocchio::unittest::HumanoidSimple;
 using hpp::pinocchio::unittest::HumanoidRomeo;
@@ -575,6 +584,137 @@ BOOST_AUTO_TEST_CASE(functions1)
   BOOST_CHECK_EQUAL(solver.implicitDof(), impDof);
 }
 
+BOOST_AUTO_TEST_CASE(jacobianProduct)
+{
+  LiegroupSpacePtr_t R5 (LiegroupSpace::Rn (5));
+  BySubstitution solver (R5);
+  solver.maxIterations (20);
+  solver.errorThreshold (1e-10);
+
+  /// System:
+  ///      q1 = a q0
+  ///      q2 = b1 q1 + b3 q3
+  ///      q4 = C
+  /// f (q) = g.q = 0
+  segments_t in, out;
+  in.push_back (segment_t (0, 1)); out.push_back (segment_t (1, 1));
+  solver.add (Explicit::create (R5, AffineFunction::create
+                                (matrix_t::Constant (1, 1, 2.)),
+                                in, out, in, out));
+  matrix_t B (1, 2); B << -1, 3;
+  in.clear (); out.clear ();
+  in.push_back (segment_t (1, 1)); in.push_back (segment_t (3, 1));
+  out.push_back (segment_t (2, 1));
+  solver.add (Explicit::create (R5, AffineFunction::create (B),
+                                in, out, in, out));
+  in.clear (); out.clear ();
+  out.push_back (segment_t (4, 1));
+  solver.add (Explicit::create (R5, AffineFunction::create
+                                (matrix_t (1, 0), vector_t::Ones (1)),
+                                in, out, in, out));
+  matrix_t g (1, 5); g << 1, 1, 1, 1, 1;
+  solver.add (Implicit::create (AffineFunction::create (g),
+                                ComparisonTypes_t (1, EqualToZero)));
+
+  const ExplicitConstraintSet& explicitSet (solver.explicitConstraintSet ());
+  BOOST_CHECK_EQUAL (explicitSet.notOutDers ().nbIndices (), 2);
+  vector_t q (vector_t::Random (5));
+  explicitSet.solve (q);
+
+  // Forward: product by the Jacobian of the resolution
+  matrix_t J (5, 5), G (matrix_t::Random (3, 5));
+  explicitSet.jacobian (J, q);
+  matrix_t Je (explicitSet.jacobianNotOutToOut (J).eval ());
+  matrix_t Gout (3, 3);
+  Gout << G.col (1), G.col (2), G.col (4);
+  matrix_t expected (Gout * Je);
+  // Reverse accumulation
+  matrix_t result (3, 2);
+  explicitSet.jacobianProduct (q, G, result);
+  BOOST_CHECK_MESSAGE (result.isApprox (expected),
+                       "result:\n" << result << "\nexpected:\n" << expected);
+
+  // One implicit row: the solver uses reverse accumulation.
+  // f (q) = q0 + 2 q0 + (-2 q0 + 3 q3) + q3 + 1 = q0 + 4 q3 + 1
+  BOOST_CHECK_EQUAL (solver.solve (q), BySubstitution::SUCCESS);
+  BOOST_CHECK_SMALL (q [0] + 4 * q [3] + 1, 1e-8);
+}
+
+BOOST_AUTO_TEST_CASE(explicitSplit)
+{
+  LiegroupSpacePtr_t R5 (LiegroupSpace::Rn (5));
+  segments_t in, out;
+
+  /// q3 = b (q0): forms a cycle with a
+  in.push_back (segment_t (0, 1)); out.push_back (segment_t (3, 1));
+  ExplicitPtr_t b (Explicit::create (R5, AffineFunction::create
+                                     (matrix_t::Ones (1, 1)),
+                                     in, out, in, out));
+  /// q1 = c (q4): output overlaps the output of a
+  in.clear (); out.clear ();
+  in.push_back (segment_t (4, 1)); out.push_back (segment_t (1, 1));
+  ExplicitPtr_t c (Explicit::create (R5, AffineFunction::create
+                                     (matrix_t::Ones (1, 1)),
+                                     in, out, in, out));
+  /// (q0, q1, q2) = a (q3)
+  in.clear (); out.clear ();
+  in.push_back (segment_t (3, 1)); out.push_back (segment_t (0, 3));
+  ExplicitPtr_t a (Explicit::create (R5, AffineFunction::create
+                                     (matrix_t::Ones (3, 1)),
+                                     in, out, in, out));
+  NumericalConstraints_t constraints;
+  constraints.push_back (b);
+  constraints.push_back (c);
+  constraints.push_back (a);
+
+  // Added one by one, b and c are explicit and eliminate 2 variables.
+  BySubstitution greedy (R5);
+  for (std::size_t i = 0; i < constraints.size (); ++i)
+    greedy.add (constraints [i]);
+  BOOST_CHECK_EQUAL (greedy.explicitConstraintSet ().notOutDers ().
+                     nbIndices (), 3);
+
+  BySubstitution solver (R5);
+  std::vector <bool> selected (solver.explicitSplit (constraints));
+  BOOST_REQUIRE_EQUAL (selected.size (), 3);
+  BOOST_CHECK (!selected [0]);
+  BOOST_CHECK (!selected [1]);
+  BOOST_CHECK (selected [2]);
+  BOOST_CHECK_EQUAL (solver.add (constraints), 3);
+  BOOST_CHECK_EQUAL (solver.explicitConstraintSet ().notOutDers ().
+                     nbIndices (), 2);
+  BOOST_CHECK_EQUAL (solver.dimension (), 2);
+  BOOST_CHECK_EQUAL (solver.numericalConstraints ().size (), 3);
+  // Constraints already in the solver are skipped.
+  BOOST_CHECK_EQUAL (solver.add (constraints), 0);
+
+  vector_t q (vector_t::Random (5));
+  BOOST_CHECK_EQUAL (solver.solve (q), BySubstitution::SUCCESS);
+  BOOST_CHECK (solver.isSatisfied (q));
+
+  /// (q1, q3) = d (q4): the outputs of d are not contiguous, d is not
+  /// selected and does not prevent e from being selected.
+  /// q3 = e (q4)
+  in.clear (); out.clear ();
+  in.push_back (segment_t (4, 1));
+  out.push_back (segment_t (1, 1)); out.push_back (segment_t (3, 1));
+  ExplicitPtr_t d (Explicit::create (R5, AffineFunction::create
+                                     (matrix_t::Ones (2, 1)),
+                                     in, out, in, out));
+  out.clear (); out.push_back (segment_t (3, 1));
+  ExplicitPtr_t e (Explicit::create (R5, AffineFunction::create
+                                     (matrix_t::Ones (1, 1)),
+                                     in, out, in, out));
+  constraints.clear ();
+  constraints.push_back (d);
+  constraints.push_back (e);
+  BySubstitution other (R5);
+  selected = other.explicitSplit (constraints);
+  BOOST_REQUIRE_EQUAL (selected.size (), 2);
+  BOOST_CHECK (!selected [0]);
+  BOOST_CHECK (selected [1]);
+}
+
 BOOST_AUTO_TEST_CASE(functions2)
 {
   BySubstitution solver(LiegroupSpace::R3 ());
@@ -736,6 +876,9 @@ BOOST_AUTO_TEST_CASE(hybrid_solver)
   BOOST_CHECK_EQUAL(solver.solve<Backtracking  >(qrand),
                     BySubstitution::SUCCESS);
   qrand = g.vector();
+  BOOST_CHECK_EQUAL(solver.solve<Interpolation >(qrand),
+                    BySubstitution::SUCCESS);
+  qrand = g.vector();
   BOOST_CHECK_EQUAL(solver.solve<ErrorNormBased>(qrand),
                     BySubstitution::SUCCESS);
   qrand = g.vector();
@@ -745,6 +888,264 @@ BOOST_AUTO_TEST_CASE(hybrid_solver)
                     BySubstitution::SUCCESS);
 }
 
+// Optimization of the last level used before the damped Gauss-Newton
+// steps: a step that breaks the constraints is cancelled and halved, and
+// the scaling of the steps is doubled, up to one half, when the cost
+// decreases. It stops only when the steps vanish.
+struct StepScaling : BySubstitution
+{
+  StepScaling (const BySubstitution& solver) : BySubstitution (solver) {}
+
+  // Return the number of iterations
+  template <typename LineSearch>
+  size_type optimize (vectorOut_t arg, LineSearch lineSearch) const
+  {
+    explicitConstraintSet ().solve (arg);
+    computeValue<true> (arg);
+    computeError ();
+    value_type previousCost = datas_.back ().error.squaredNorm ();
+    value_type scaling = 1;
+    bool onlyLineSearch = false;
+    vector_t qopt;
+    if (squaredNorm_ <= .25 * squaredErrorThreshold_) qopt = arg;
+    size_type iter = 0;
+    for (; iter < maxIterations_; ++iter) {
+      if (!onlyLineSearch) {
+        updateJacobian (arg);
+        computeSaturation (arg);
+        computeDescentDirection ();
+      }
+      dq_ *= scaling;
+      if (dq_.squaredNorm () < Eigen::NumTraits<value_type>::dummy_precision ())
+        break;
+      lineSearch (static_cast <const BySubstitution&> (*this), arg, dq_);
+      explicitConstraintSet ().solve (arg);
+      computeValue<true> (arg);
+      computeError ();
+      if (squaredNorm_ <= .25 * squaredErrorThreshold_) {
+        const value_type cost = datas_.back ().error.squaredNorm ();
+        if (cost < previousCost) {
+          qopt = arg;
+          previousCost = cost;
+          if (scaling < 0.5) scaling *= 2;
+        }
+        onlyLineSearch = false;
+      } else {
+        dq_ /= scaling;
+        scaling *= 0.5;
+        if (qopt.size () > 0) arg = qopt;
+        onlyLineSearch = true;
+      }
+    }
+    if (qopt.size () > 0) arg = qopt;
+    return iter;
+  }
+};
+
+BOOST_AUTO_TEST_CASE(optimize_last_level)
+{
+  DevicePtr_t device (makeDevice (HumanoidSimple));
+  BOOST_REQUIRE (device);
+  for (size_type i = 0; i < 3; ++i) {
+    device->rootJoint()->lowerBound (i, -1);
+    device->rootJoint()->upperBound (i,  1);
+  }
+  JointPtr_t ee (device->getJointByName ("lleg6_joint"));
+
+  Configuration_t q0 = device->neutralConfiguration ();
+  device->currentConfiguration (q0);
+  device->computeForwardKinematics ();
+  Transform3f tf (ee->currentTransformation ());
+
+  // Posture closest to a random configuration with a fixed foot.
+  Configuration_t goal (device->configSize ());
+  randomConfig (device, goal);
+  ImplicitPtr_t posture (Implicit::create
+    (ConfigurationConstraint::create ("Posture", device, goal),
+     ComparisonTypes_t (1, EqualToZero)));
+
+  BySubstitution solver (device->configSpace ());
+  solver.maxIterations (100);
+  solver.errorThreshold (1e-4);
+  solver.saturation (hpp::make_shared<saturation::Device>(device));
+  solver.lastIsOptional (true);
+  solver.add (Implicit::create (Transformation::create
+    ("Transformation lleg6_joint", device, ee, tf),
+     6*EqualToZero), 0);
+  solver.add (posture, 1);
+  BOOST_CHECK_EQUAL (solver.optimizationTolerance (), 1e-6);
+  BOOST_CHECK_THROW (solver.optimizationTolerance (-1),
+                     std::invalid_argument);
+  BOOST_CHECK (solver.isSatisfied (q0));
+
+  LiegroupElement cost (posture->function ().outputSpace ());
+  posture->function ().value (cost, q0);
+  const value_type initialCost (cost.vector ().squaredNorm ());
+
+  Configuration_t q (q0);
+  BOOST_CHECK_EQUAL (solver.solve<Backtracking> (q, true),
+                     BySubstitution::SUCCESS);
+  BOOST_CHECK (solver.isSatisfied (q));
+  BOOST_CHECK (solver.iterations () < solver.maxIterations ());
+  posture->function ().value (cost, q);
+  const value_type finalCost (cost.vector ().squaredNorm ());
+  BOOST_CHECK (finalCost < initialCost);
+  const size_type iterations (solver.iterations ());
+
+  // Compare with the step scaling optimizer on the same problem.
+  StepScaling baseline (solver);
+  Configuration_t qb (q0);
+  const size_type baselineIterations (baseline.optimize (qb, Backtracking ()));
+  BOOST_CHECK (baseline.isSatisfied (qb));
+  posture->function ().value (cost, qb);
+  BOOST_TEST_MESSAGE ("Step scaling: " << baselineIterations
+                      << " iterations, cost " << cost.vector ().squaredNorm ()
+                      << ". Damped steps: " << iterations
+                      << " iterations, cost " << finalCost << ".");
+  BOOST_CHECK (iterations < baselineIterations);
+  // With as many iterations, the step scaling optimizer ends with a higher
+  // cost.
+  baseline.maxIterations (iterations);
+  qb = q0;
+  baseline.optimize (qb, Backtracking ());
+  BOOST_CHECK (baseline.isSatisfied (qb));
+  posture->function ().value (cost, qb);
+  BOOST_CHECK (finalCost < cost.vector ().squaredNorm ());
+
+  // A larger tolerance stops the optimization earlier.
+  solver.optimizationTolerance (1e-1);
+  q = q0;
+  BOOST_CHECK_EQUAL (solver.solve<Backtracking> (q, true),
+                     BySubstitution::SUCCESS);
+  BOOST_CHECK (solver.isSatisfied (q));
+  BOOST_CHECK (solver.iterations () <= iterations);
+}
+
+BOOST_AUTO_TEST_CASE(restricted_integrate)
+{
+  DevicePtr_t device (makeDevice (HumanoidSimple));
+  BOOST_REQUIRE (device);
+  for (size_type i = 0; i < 3; ++i) {
+    device->rootJoint()->lowerBound (i, -1);
+    device->rootJoint()->upperBound (i,  1);
+  }
+  JointPtr_t lleg5Joint (device->getJointByName ("lleg5_joint")),
+             lleg6Joint (device->getJointByName ("lleg6_joint")),
+             larm6Joint (device->getJointByName ("larm6_joint"));
+
+  // Only the root joint and lleg6_joint are free.
+  HierarchicalIterative solver (device->configSpace ());
+  solver.saturation (hpp::make_shared<saturation::Device> (device));
+  segments_t free;
+  free.push_back (segment_t (0, 6));
+  free.push_back (segment_t (lleg6Joint->rankInVelocity (), 1));
+  solver.freeVariables (free);
+
+  saturation::Device saturate (device);
+  Eigen::VectorXi sat (device->numberDof ());
+  Configuration_t q (::pinocchio::randomConfiguration (device->model ())),
+    expected (device->configSize ()), result (device->configSize ());
+
+  // Velocity of the free variables only: lleg6_joint is saturated.
+  vector_t v (vector_t::Zero (device->numberDof ()));
+  v.head<6> ().setRandom ();
+  v [lleg6Joint->rankInVelocity ()] = 10;
+  LiegroupElement g (q, device->configSpace ());
+  g += v;
+  saturate.saturate (g.vector (), expected, sat);
+  BOOST_CHECK (solver.integrate (q, v, result));
+  BOOST_CHECK (result.isApprox (expected));
+
+  // Variables that are not free but have a non-zero velocity are integrated.
+  v [lleg5Joint->rankInVelocity ()] = .1;
+  g = LiegroupElement (q, device->configSpace ());
+  g += v;
+  saturate.saturate (g.vector (), expected, sat);
+  solver.integrate (q, v, result);
+  BOOST_CHECK (result.isApprox (expected));
+
+  // In place integration
+  Configuration_t q1 (q);
+  solver.integrate (q1, v, q1);
+  BOOST_CHECK (q1.isApprox (expected));
+
+  // Variables that are neither free nor moved are left unchanged, even out of
+  // bounds.
+  const size_type iq (larm6Joint->rankInConfiguration ());
+  q [iq] = larm6Joint->upperBound (0) + 1;
+  solver.integrate (q, v, result);
+  BOOST_CHECK_EQUAL (result [iq], q [iq]);
+}
+
+BOOST_AUTO_TEST_CASE(solve_snapshot)
+{
+  BySubstitution solver (LiegroupSpace::R3 ());
+  solver.maxIterations (20);
+  solver.errorThreshold (1e-8);
+
+  /// System:
+  /// f (q) = q0 + q2 - 1 = 0
+  ///    q1 = q2
+  matrix_t J (1, 3); J << 1, 0, 1;
+  ImplicitPtr_t impl (Implicit::create
+                      (AffineFunction::create (J, vector_t::Constant (1, -1)),
+                       ComparisonTypes_t (1, EqualToZero)));
+  solver.add (impl);
+  segments_t in; in.push_back (segment_t (2, 1));
+  segments_t out; out.push_back (segment_t (1, 1));
+  ExplicitPtr_t expl (Explicit::create
+                      (LiegroupSpace::R3 (),
+                       AffineFunction::create (matrix_t::Ones (1, 1)),
+                       in, out, in, out));
+  solver.add (expl);
+  BOOST_CHECK (!solver.snapshot ().valid);
+
+  // The snapshot is not stored by default.
+  vector_t q (vector_t::Random (3)), error (solver.dimension ()), e (1);
+  bool found;
+  BOOST_CHECK (!solver.storeSnapshot ());
+  BOOST_CHECK_EQUAL (solver.solve (q), BySubstitution::SUCCESS);
+  BOOST_CHECK (!solver.snapshot ().valid);
+  BOOST_CHECK_THROW (solver.snapshotConstraintSatisfied (impl, e, found),
+                     std::logic_error);
+
+  solver.storeSnapshot (true);
+  q = vector_t::Random (3);
+  BOOST_CHECK_EQUAL (solver.solve (q), BySubstitution::SUCCESS);
+  BOOST_REQUIRE (solver.snapshot ().valid);
+  BOOST_CHECK_EQUAL (solver.snapshot ().config, q);
+  BOOST_CHECK_EQUAL (solver.snapshot ().jacobian.size (), 0);
+
+  // The snapshot is the error at the returned configuration.
+  solver.HierarchicalIterative::isSatisfied (q);
+  solver.residualError (error);
+  BOOST_CHECK ((solver.snapshot ().error - error).norm () < 1e-12);
+  BOOST_CHECK (solver.snapshot ().squaredNorm < 1e-16);
+
+  BOOST_CHECK (solver.snapshotConstraintSatisfied (impl, e, found));
+  BOOST_CHECK (found);
+  BOOST_CHECK (e.norm () < 1e-8);
+  BOOST_CHECK (solver.snapshotConstraintSatisfied (expl, e, found));
+  BOOST_CHECK (found);
+  ImplicitPtr_t other (Implicit::create
+                       (AffineFunction::create (J),
+                        ComparisonTypes_t (1, EqualToZero)));
+  BOOST_CHECK (!solver.snapshotConstraintSatisfied (other, e, found));
+  BOOST_CHECK (!found);
+
+  // Jacobian
+  solver.snapshotJacobian (true);
+  q = vector_t::Random (3);
+  BOOST_CHECK_EQUAL (solver.solve (q), BySubstitution::SUCCESS);
+  BOOST_REQUIRE (solver.snapshot ().valid);
+  BOOST_CHECK_EQUAL (solver.snapshot ().jacobian.rows (), 1);
+  BOOST_CHECK_EQUAL (solver.snapshot ().jacobian.cols (), 3);
+  BOOST_CHECK (solver.snapshot ().jacobian.isApprox (J));
+
+  solver.storeSnapshot (false);
+  BOOST_CHECK (!solver.snapshot ().valid);
+}
+
 BOOST_AUTO_TEST_CASE(by_substitution_serialization)
 {
   DevicePtr_t device (makeDevice (HumanoidSimple));
@@ -809,6 +1210,91 @@ BOOST_AUTO_TEST_CASE(by_substitution_serialization)
   BOOST_CHECK_EQUAL(ss_expect.str(), ss_result.str());
 }
 
+BOOST_AUTO_TEST_CASE(by_substitution_recorder)
+{
+  DevicePtr_t device (makeDevice (HumanoidSimple));
+  BOOST_REQUIRE (device);
+  for (size_type i = 0; i < 3; ++i) {
+    device->rootJoint()->lowerBound (i, -1);
+    device->rootJoint()->upperBound (i,  1);
+  }
+  JointPtr_t ee1 = device->getJointByName ("rleg5_joint"),
+             ee2 = device->getJointByName ("lleg5_joint");
+
+  Configuration_t q = device->currentConfiguration ();
+  device->currentConfiguration (q);
+  device->computeForwardKinematics ();
+  Transform3f tf1 (ee1->currentTransformation ());
+  Transform3f tf2 (ee2->currentTransformation ());
+
+  BySubstitution solver(device->configSpace ());
+  solver.maxIterations(20);
+  solver.errorThreshold(1e-3);
+  solver.saturation(hpp::make_shared<saturation::Device>(device));
+  solver.add
+    (Implicit::create
+     (Orientation::create ("Orientation RAnkleRoll" , device, ee2, tf2),
+      3 * Equality));
+  solver.add
+    (LockedJoint::create
+     (ee1, ee1->configurationSpace ()->neutral ()));
+
+  // Options that are not serialized with the solver
+  solver.mixedPrecision (1e4);
+  solver.activeBoundSteps (true);
+  Backtracking backtracking;
+  backtracking.tau = 0.5;
+
+  std::stringstream ss;
+  Recorder::Record record, result;
+  std::vector<BySubstitution::Status> statuses;
+  std::vector<Configuration_t> outputs;
+  {
+    RecorderPtr_t recorder (Recorder::create (ss, device));
+    solver.recorder (recorder);
+    for (int i = 0; i < 5; ++i) {
+      q = ::pinocchio::randomConfiguration(device->model());
+      statuses.push_back (solver.solve (q, backtracking));
+      outputs.push_back (q);
+    }
+    q = ::pinocchio::randomConfiguration(device->model());
+    statuses.push_back (solver.solve (q, true, Constant ()));
+    outputs.push_back (q);
+    BOOST_CHECK_EQUAL (recorder->numberRecords (), statuses.size ());
+
+    // The cached solutions would not be recorded.
+    solver.solutionCache (4, 0.1);
+    BOOST_CHECK_THROW (solver.solve (q, backtracking), std::logic_error);
+    solver.solutionCache (0, 0);
+    solver.recorder (RecorderPtr_t ());
+  }
+
+  std::size_t n = 0;
+  while (Recorder::read (ss, record)) {
+    BOOST_REQUIRE (n < statuses.size ());
+    BOOST_CHECK (record.bySubstitution);
+    BOOST_CHECK_EQUAL (record.robotName, device->name ());
+    BOOST_CHECK_EQUAL (record.status, statuses [n]);
+    BOOST_CHECK_EQUAL (record.optimize, n + 1 == statuses.size ());
+    BOOST_CHECK_EQUAL (record.lineSearch, n + 1 == statuses.size () ?
+                       Recorder::CONSTANT : Recorder::BACKTRACKING);
+    EIGEN_VECTOR_IS_APPROX (record.output, outputs [n]);
+    BOOST_CHECK_EQUAL (record.options.mixedPrecision, 1e4);
+    BOOST_CHECK (record.options.activeBoundSteps);
+    if (record.lineSearch == Recorder::BACKTRACKING) {
+      BOOST_REQUIRE_EQUAL (record.lineSearchParameters.size (), 3);
+      BOOST_CHECK_EQUAL (record.lineSearchParameters [1], 0.5);
+    }
+
+    Recorder::replay (record, device, result);
+    BOOST_CHECK_EQUAL (result.status, record.status);
+    BOOST_CHECK_EQUAL (result.iterations, record.iterations);
+    EIGEN_VECTOR_IS_APPROX (result.output, record.output);
+    ++n;
+  }
+  BOOST_CHECK_EQUAL (n, statuses.size ());
+}
+
 BOOST_AUTO_TEST_CASE(hybrid_solver_rhs)
 {
   using namespace hpp::constraints;
@@ -1120,3 +1606,265 @@ BOOST_AUTO_TEST_CASE (merge)
   solver5.add (c3);
   BOOST_CHECK (solver5.contains (c3->copy ()));
 }
+
+BOOST_AUTO_TEST_CASE (automaticPromotion)
+{
+  using namespace hpp::constraints;
+
+  DevicePtr_t device (makeDevice (HumanoidRomeo));
+  BOOST_REQUIRE (device);
+  JointPtr_t root (device->jointAt (0));
+  BOOST_REQUIRE (*root->configurationSpace () == *LiegroupSpace::SE3 ());
+  JointPtr_t left = device->getJointByName ("LWristPitch");
+
+  Transform3f frame2 (Transform3f::Identity ());
+  frame2.translation () << 0, 0, .1;
+  ImplicitPtr_t c1 (Implicit::create (TransformationR3xSO3::create
+      ("root pose", device, root, frame2), 6 * Equality));
+  // Joint 2 is an ancestor of joint 1: the constraint stays implicit.
+  ImplicitPtr_t c2 (Implicit::create (RelativeTransformationR3xSO3::create
+      ("wrist in root", device, left, root, Transform3f::Identity (),
+       Transform3f::Identity ()), 6 * Equality));
+
+  BySubstitution solver (device->configSpace ());
+  solver.maxIterations (20);
+  solver.errorThreshold (1e-6);
+  BOOST_CHECK (!solver.automaticPromotion ());
+  solver.automaticPromotion (true);
+  solver.add (c1);
+  solver.add (c2);
+
+  BOOST_CHECK (solver.contains (c1));
+  BOOST_CHECK (solver.contains (c2));
+  BOOST_CHECK_EQUAL (solver.numberFreeVariables (), device->numberDof () - 6);
+  BOOST_CHECK_EQUAL (solver.numberStacks (), 1);
+  BOOST_CHECK_EQUAL (solver.rightHandSideSize (), 14);
+
+  Configuration_t q (::pinocchio::randomConfiguration (device->model ()));
+  BOOST_CHECK (solver.rightHandSideFromConfig (c1, q));
+  vector_t rhs (7);
+  BOOST_CHECK (solver.getRightHandSide (c1, rhs));
+  LiegroupElement value (c1->function ().outputSpace ());
+  c1->function ().value (value, q);
+  SE3CONFIG_IS_APPROX (value.vector (), rhs);
+
+  vector_t error (6);
+  bool found;
+  for (int i = 0; i < 10; ++i) {
+    Configuration_t qrand (::pinocchio::randomConfiguration (device->model ()));
+    // c2 does not depend on the root pose set by c1.
+    solver.rightHandSideFromConfig (c2, qrand);
+    BOOST_CHECK_EQUAL (solver.solve<FixedSequence> (qrand),
+                       BySubstitution::SUCCESS);
+    BOOST_CHECK (solver.isConstraintSatisfied (c1, qrand, error, found));
+    BOOST_CHECK (found);
+    BOOST_CHECK (solver.isConstraintSatisfied (c2, qrand, error, found));
+    BOOST_CHECK (found);
+  }
+
+  BySubstitution solver1 (solver);
+  BOOST_CHECK (solver1.contains (c1));
+  BOOST_CHECK (solver1.getRightHandSide (c1, rhs));
+  SE3CONFIG_IS_APPROX (value.vector (), rhs);
+}
+
+BOOST_AUTO_TEST_CASE (solutionCache)
+{
+  size_type N (5), M (3);
+  matrix_t A (matrix_t::Random (M, N));
+  AffineFunctionPtr_t affine (AffineFunction::create (A));
+  ImplicitPtr_t constraint (Implicit::create (affine, M * Equality));
+
+  BySubstitution solver (LiegroupSpace::Rn (N));
+  solver.maxIterations (20);
+  solver.errorThreshold (test_precision);
+  solver.add (constraint);
+  BOOST_CHECK_EQUAL (solver.solutionCacheSize (), 0);
+  solver.solutionCache (10, 10., 1e-2);
+  BOOST_CHECK_EQUAL (solver.solutionCacheSize (), 10);
+
+  vector_t b (vector_t::Random (M));
+  solver.rightHandSide (constraint, b);
+
+  // First resolution: nothing in the cache.
+  vector_t x0 (vector_t::Random (N)), x (x0);
+  BOOST_CHECK_EQUAL (solver.solve (x), BySubstitution::SUCCESS);
+  BOOST_CHECK ((A * x - b).norm () < test_precision);
+  BOOST_CHECK_EQUAL (solver.solutionCacheStatistics ().misses, 1);
+  BOOST_CHECK_EQUAL (solver.solutionCacheStatistics ().hits, 0);
+
+  // Same right hand side: the cached solution is returned.
+  const vector_t x1 (x);
+  x = x0;
+  BOOST_CHECK_EQUAL (solver.solve (x), BySubstitution::SUCCESS);
+  BOOST_CHECK (x == x1);
+  BOOST_CHECK_EQUAL (solver.solutionCacheStatistics ().hits, 1);
+
+  // Close right hand side: resolution starts from the cached solution.
+  b [0] += 1e-3;
+  solver.rightHandSide (constraint, b);
+  x = x0;
+  BOOST_CHECK_EQUAL (solver.solve (x), BySubstitution::SUCCESS);
+  BOOST_CHECK ((A * x - b).norm () < test_precision);
+  BOOST_CHECK_EQUAL (solver.solutionCacheStatistics ().warmStarts, 1);
+
+  // Far right hand side: the cache is not used.
+  b [0] += 1.;
+  solver.rightHandSide (constraint, b);
+  x = x0;
+  BOOST_CHECK_EQUAL (solver.solve (x), BySubstitution::SUCCESS);
+  BOOST_CHECK ((A * x - b).norm () < test_precision);
+  BOOST_CHECK_EQUAL (solver.solutionCacheStatistics ().misses, 2);
+  BOOST_CHECK_EQUAL (solver.solutionCacheStatistics ().warmStarts, 1);
+  BOOST_CHECK_EQUAL (solver.solutionCacheStatistics ().hits, 1);
+
+  // Adding a constraint clears the cache.
+  solver.add (Implicit::create (AffineFunction::create
+                                (matrix_t::Random (1, N)), 1 * EqualToZero));
+  x = x0;
+  solver.solve (x);
+  BOOST_CHECK_EQUAL (solver.solutionCacheStatistics ().misses, 3);
+}
+
+BOOST_AUTO_TEST_CASE (solvePath)
+{
+  DevicePtr_t device (makeDevice (HumanoidRomeo));
+  BOOST_REQUIRE (device);
+  JointPtr_t left = device->getJointByName ("LWristPitch"),
+    right = device->getJointByName ("RWristPitch");
+  Transform3f tf (Transform3f::Identity ());
+  tf.translation () << 0, .3, 0;
+  ImplicitPtr_t c (Implicit::create (RelativeTransformation::create
+      ("hands", device, left, right, tf, Transform3f::Identity ()),
+       6 * EqualToZero));
+
+  BySubstitution solver (device->configSpace ());
+  solver.maxIterations (40);
+  solver.errorThreshold (1e-6);
+  solver.add (c);
+
+  // Discretize a straight path between two configurations
+  const size_type K (10);
+  Configuration_t q0 (device->neutralConfiguration ()),
+    q1 (device->configSize ());
+  ::pinocchio::integrate (device->model (), q0,
+                          .2 * vector_t::Random (device->numberDof ()), q1);
+  matrix_t path (device->configSize (), K);
+  for (size_type k = 0; k < K; ++k) {
+    ::pinocchio::interpolate (device->model (), q0, q1,
+                              (value_type) k / (value_type) (K - 1),
+                              path.col (k));
+  }
+
+  // Largest and sum of squared distances between consecutive samples
+  value_type maxJump[2], sumJumps[2];
+  for (int i = 0; i < 2; ++i) {
+    const value_type continuity (i);
+    matrix_t projected (path);
+    BOOST_CHECK_EQUAL (solver.solvePath (projected, continuity),
+                       BySubstitution::SUCCESS);
+    maxJump[i] = sumJumps[i] = 0;
+    for (size_type k = 0; k < K; ++k) {
+      BOOST_CHECK (solver.isSatisfied (projected.col (k)));
+      if (k == 0) continue;
+      vector_t v (device->numberDof ());
+      ::pinocchio::difference (device->model (), projected.col (k - 1),
+                               projected.col (k), v);
+      maxJump[i] = std::max (maxJump[i], v.norm ());
+      sumJumps[i] += v.squaredNorm ();
+    }
+  }
+  // The continuity term reduces the jumps between consecutive samples.
+  BOOST_TEST_MESSAGE ("largest jump: " << maxJump[0] << " without continuity, "
+                      << maxJump[1] << " with continuity");
+  BOOST_CHECK (sumJumps[1] <= sumJumps[0]);
+  BOOST_CHECK (maxJump[1] <= maxJump[0]);
+}
+
+BOOST_AUTO_TEST_CASE (solvePath_explicit)
+{
+  // (x y z) A (x y z) = 1 with y = B z
+  const size_type N1 (2), N2 (2), N3 (2), N (N1 + N2 + N3);
+  Quadratic::Ptr_t quad (new Quadratic (randomPositiveDefiniteMatrix (N), -1));
+  matrix_t B (matrix_t::Random (N2, N3));
+  segments_t in; in.push_back (segment_t (N1 + N2, N3));
+  segments_t out; out.push_back (segment_t (N1, N2));
+  ExplicitPtr_t expl (Explicit::create (LiegroupSpace::Rn (N),
+                                        AffineFunction::create (B),
+                                        in, out, in, out));
+
+  BySubstitution solver (LiegroupSpace::Rn (N));
+  solver.maxIterations (40);
+  solver.errorThreshold (1e-6);
+  solver.add (Implicit::create (quad, ComparisonTypes_t (1, EqualToZero)));
+  solver.add (expl);
+  BOOST_REQUIRE (solver.explicitConstraintSet ().contains (expl));
+
+  // Straight path between two configurations far from the constraints
+  const size_type K (8);
+  vector_t x0 (vector_t::Constant (N, 2)), x1 (vector_t::Constant (N, 2));
+  x0.head (N1) << 1, -1;
+  x1.tail (N3) << -1, 1;
+  matrix_t path (N, K);
+  for (size_type k = 0; k < K; ++k) {
+    const value_type t ((value_type) k / (value_type) (K - 1));
+    path.col (k) = (1 - t) * x0 + t * x1;
+  }
+
+  for (int i = 0; i < 2; ++i) {
+    matrix_t projected (path);
+    BOOST_CHECK_EQUAL (solver.solvePath (projected, (value_type) i),
+                       BySubstitution::SUCCESS);
+    for (size_type k = 0; k < K; ++k) {
+      BOOST_CHECK (solver.isSatisfied (projected.col (k)));
+      // The explicit outputs correspond to the projected inputs.
+      EIGEN_VECTOR_IS_APPROX (projected.col (k).segment (N1, N2),
+                              B * projected.col (k).tail (N3));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE (tangentBasis)
+{
+  const size_type N (8), M (3);
+  matrix_t A (matrix_t::Random (M, N));
+  BySubstitution solver (LiegroupSpace::Rn (N));
+  solver.add (Implicit::create (AffineFunction::create (A), M * EqualToZero));
+
+  vector_t x (vector_t::Random (N));
+  matrix_t B (solver.tangentBasis (x));
+  BOOST_CHECK_EQUAL (B.rows (), N);
+  BOOST_CHECK_EQUAL (B.cols (), N - M);
+  BOOST_CHECK ((A * B).norm () < 1e-10);
+  BOOST_CHECK ((B.transpose () * B - matrix_t::Identity (N - M, N - M)).norm ()
+               < 1e-10);
+
+  // Basis at another configuration
+  x = vector_t::Random (N);
+  B = solver.tangentBasis (x);
+  BOOST_CHECK_EQUAL (B.cols (), N - M);
+  BOOST_CHECK ((A * B).norm () < 1e-10);
+
+  // Projection on the cached tangent space
+  solver.computeTangentSpace (x);
+  vector_t v (vector_t::Random (N)), p1 (N), p2 (N);
+  solver.projectVectorOnTangentSpace (v, p1);
+  solver.projectVectorOnKernel (x, v, p2);
+  BOOST_CHECK ((p1 - p2).norm () < 1e-10);
+  BOOST_CHECK ((A * p1).norm () < 1e-10);
+  // Same projection as with the explicit basis
+  BOOST_CHECK ((p1 - B * (B.transpose () * v)).norm () < 1e-10);
+
+  // Rank deficient Jacobian
+  matrix_t A2 (M + 1, N);
+  A2 << A, A.row (0) + A.row (1);
+  BySubstitution solver2 (LiegroupSpace::Rn (N));
+  solver2.add (Implicit::create (AffineFunction::create (A2),
+                                 (M + 1) * EqualToZero));
+  B = solver2.tangentBasis (x);
+  BOOST_CHECK_EQUAL (B.cols (), N - M);
+  BOOST_CHECK ((A2 * B).norm () < 1e-10);
+  solver2.computeTangentSpace (x);
+  solver2.projectVectorOnTangentSpace (v, p2);
+  BOOST_CHECK ((p1 - p2).norm () < 1e-10);
+}
@@ -32,6 +32,7 @@
 #include <hpp/constraints/generic-transformation.hh>
 #include <hpp/constraints/implicit.hh>
 #include <hpp/constraints/affine-function.hh>
+#include <hpp/constraints/task-scheduler.hh>
 
 #include <../tests/util.hh>
 
@@ -118,6 +119,20 @@ BOOST_AUTO_TEST_CASE(quadratic)
   BOOST_CHECK_EQUAL (test.success (1, 0.001), VECTOR2(1,1)); // Slide on the border x = 1
   BOOST_CHECK_EQUAL (test.success (0.001, 1), VECTOR2(1,1)); // Slide on the border y = 1
 
+  // Variables at bounds are removed from the problem.
+  test.solver.activeBoundSteps (true);
+  BOOST_CHECK (test.solver.activeBoundSteps ());
+  BOOST_CHECK_EQUAL (test.success (1, 0.001), VECTOR2(1,1));
+  BOOST_CHECK_EQUAL (test.success (0.001, 1), VECTOR2(1,1));
+  test.solver.activeBoundSteps (false);
+
+  // Single precision decompositions far from the solution
+  test.solver.mixedPrecision (1e4);
+  BOOST_CHECK_EQUAL (test.solver.mixedPrecision (), 1e4);
+  BOOST_CHECK_EQUAL (test.success (1, 0.001), VECTOR2(1,1));
+  BOOST_CHECK_EQUAL (test.success (0.001, 1), VECTOR2(1,1));
+  test.solver.mixedPrecision (0);
+
   A << 0.75, 0, 0, 0.75;
   test_quadratic<solver::lineSearch::FixedSequence> test4 (A);
   // This is not exact because the solver does not saturate.
@@ -135,6 +150,45 @@ BOOST_AUTO_TEST_CASE(quadratic)
   EIGEN_VECTOR_IS_APPROX (test1.success (0, 1), VECTOR2(0.,1/sqrt(2)));
 }
 
+BOOST_AUTO_TEST_CASE(active_bound_steps)
+{
+  // f (x) = (3 x0 - x2 + x3, -2 x0 + x1 + x2 - 2 x3 + 1), 0 <= x <= 1
+  // The solution (0, 0, 1, 1) lies on the bounds. The first step saturates
+  // x0 and x3. The gradient of the error only keeps x0 at its bound, so the
+  // following steps alternately saturate x0 and x1.
+  matrix_t A (2, 4);
+  A << 3, 0, -1, 1,
+      -2, 1, 1, -2;
+  vector_t b (2);
+  b << 0, 1;
+  solver::HierarchicalIterative solver (LiegroupSpace::Rn (4));
+  solver.maxIterations (100);
+  solver.errorThreshold (test_precision);
+  solver.saturation (hpp::make_shared<saturation::Bounds>
+                     (vector_t::Zero (4), vector_t::Ones (4)));
+  solver.add (Implicit::create (AffineFunction::create (A, b),
+                                2 * EqualToZero), 0);
+  vector_t x0 (4);
+  x0 << 0.1, 0.5, 0.75, 0.75;
+
+  vector_t x (x0);
+  BOOST_CHECK_EQUAL (solver.solve (x, solver::lineSearch::Constant ()),
+                     solver::HierarchicalIterative::SUCCESS);
+  const size_type iterations (solver.iterations ());
+
+  // Variables pushed to their bounds by the previous step stay there.
+  solver.activeBoundSteps (true);
+  x = x0;
+  BOOST_CHECK_EQUAL (solver.solve (x, solver::lineSearch::Constant ()),
+                     solver::HierarchicalIterative::SUCCESS);
+  BOOST_CHECK_MESSAGE (solver.iterations () < iterations,
+                       "Active bound steps: " << solver.iterations ()
+                       << " iterations, without: " << iterations);
+  vector_t expected (4);
+  expected << 0, 0, 1, 1;
+  BOOST_CHECK_SMALL ((x - expected).norm (), 1e-10);
+}
+
 BOOST_AUTO_TEST_CASE(one_layer)
 {
   DevicePtr_t device = hpp::pinocchio::unittest::makeDevice (hpp::pinocchio::unittest::HumanoidSimple);
@@ -178,9 +232,70 @@ BOOST_AUTO_TEST_CASE(one_layer)
   Configuration_t tmp = qrand;
   BOOST_CHECK_EQUAL(solver.solve<solver::lineSearch::Backtracking  >(qrand), solver::HierarchicalIterative::SUCCESS);
   qrand = tmp;
+  BOOST_CHECK_EQUAL(solver.solve<solver::lineSearch::Interpolation >(qrand), solver::HierarchicalIterative::SUCCESS);
+  qrand = tmp;
   BOOST_CHECK_EQUAL(solver.solve<solver::lineSearch::ErrorNormBased>(qrand), solver::HierarchicalIterative::SUCCESS);
   qrand = tmp;
   BOOST_CHECK_EQUAL(solver.solve<solver::lineSearch::FixedSequence >(qrand), solver::HierarchicalIterative::SUCCESS);
+
+  // Automatic scaling does not change the error threshold.
+  solver.automaticScaling (5);
+  BOOST_CHECK_EQUAL(solver.automaticScaling (), 5);
+  qrand = tmp;
+  BOOST_CHECK_EQUAL(solver.solve<solver::lineSearch::Backtracking  >(qrand), solver::HierarchicalIterative::SUCCESS);
+  BOOST_CHECK(solver.isSatisfied(qrand));
+  qrand = tmp;
+  BOOST_CHECK_EQUAL(solver.solve<solver::lineSearch::FixedSequence >(qrand), solver::HierarchicalIterative::SUCCESS);
+  BOOST_CHECK(solver.isSatisfied(qrand));
+  solver.automaticScaling (0);
+}
+
+BOOST_AUTO_TEST_CASE(restricted_saturation)
+{
+  // Only the variables that are free or moved are integrated and saturated.
+  solver::HierarchicalIterative solver (LiegroupSpace::Rn (4));
+  solver.saturation (hpp::make_shared<saturation::Bounds>
+                     (vector_t::Zero (4), vector_t::Ones (4)));
+  solver.freeVariables (segments_t (1, segment_t (0, 2)));
+
+  vector_t from (4), v (4), q (4), expected (4);
+  from << .5, .5, 2, -1;
+  v << 1, 0, 0, .5;
+  BOOST_CHECK (solver.integrate (from, v, q));
+  expected << 1, .5, 2, 0;
+  BOOST_CHECK_EQUAL (q, expected);
+
+  // Fixed variables out of their bounds are not saturated.
+  v << -.25, .25, 0, 0;
+  BOOST_CHECK (!solver.integrate (from, v, q));
+  expected << .25, .75, 2, -1;
+  BOOST_CHECK_EQUAL (q, expected);
+
+  DevicePtr_t device = hpp::pinocchio::unittest::makeDevice (hpp::pinocchio::unittest::HumanoidSimple);
+  BOOST_REQUIRE (device);
+  JointPtr_t freeJoint = device->getJointByName ("lleg5_joint"),
+             fixedJoint = device->getJointByName ("rleg5_joint");
+  BOOST_REQUIRE_EQUAL (freeJoint->configSize (), 1);
+  BOOST_REQUIRE_EQUAL (fixedJoint->configSize (), 1);
+  const size_type iqFree (freeJoint->rankInConfiguration ()),
+    ivFree (freeJoint->rankInVelocity ()),
+    iqFixed (fixedJoint->rankInConfiguration ());
+
+  solver::HierarchicalIterative robotSolver (device->configSpace ());
+  robotSolver.saturation
+    (hpp::make_shared<solver::saturation::Device> (device));
+  robotSolver.freeVariables (segments_t (1, segment_t (ivFree, 1)));
+
+  Configuration_t qFrom (device->currentConfiguration ()),
+    qTo (device->configSize ());
+  qFrom [iqFixed] = fixedJoint->upperBound (0) + 1;
+  vector_t dq (vector_t::Zero (device->numberDof ()));
+  dq [ivFree] = freeJoint->upperBound (0) - qFrom [iqFree] + 1;
+  BOOST_CHECK (robotSolver.integrate (qFrom, dq, qTo));
+  BOOST_CHECK_EQUAL (qTo [iqFree], freeJoint->upperBound (0));
+  BOOST_CHECK_EQUAL (qTo [iqFixed], qFrom [iqFixed]);
+  qTo [iqFree] = qFrom [iqFree];
+  BOOST_CHECK (qTo == qFrom);
 }
 
 template <typename LineSearch = solver::lineSearch::Constant>
@@ -222,6 +337,123 @@ struct test_affine_opt : test_base <LineSearch>
   }
 };
 
+BOOST_AUTO_TEST_CASE(parallel_evaluation)
+{
+  DevicePtr_t device = hpp::pinocchio::unittest::makeDevice (hpp::pinocchio::unittest::HumanoidSimple);
+  BOOST_REQUIRE (device);
+  device->numberDeviceData (4);
+  JointPtr_t ee1 = device->getJointByName ("lleg5_joint"),
+             ee2 = device->getJointByName ("rleg5_joint");
+
+  Configuration_t q = device->currentConfiguration (),
+                  qrand = ::pinocchio::randomConfiguration(device->model());
+  device->currentConfiguration (q);
+  device->computeForwardKinematics ();
+  Transform3f tf1 (ee1->currentTransformation ());
+  Transform3f tf2 (ee2->currentTransformation ());
+
+  solver::HierarchicalIterative solver(device->configSpace());
+  solver.maxIterations(20);
+  solver.errorThreshold(1e-3);
+  solver.saturation(hpp::make_shared<solver::saturation::Device>(device));
+  solver.add(Implicit::create
+             (Position::create ("Position", device, ee1, tf1), 3 * Equality),
+             0);
+  solver.add(Implicit::create
+             (Orientation::create ("Orientation", device, ee2, tf2),
+              3 * Equality), 1);
+  solver.add(Implicit::create
+             (Position::create ("Position", device, ee2, tf2), 3 * Equality),
+             2);
+  BOOST_CHECK(solver.numberStacks() == 3);
+  BOOST_CHECK(!solver.parallelEvaluation ());
+
+  Configuration_t serial (qrand);
+  solver::HierarchicalIterative::Status status
+    (solver.solve<solver::lineSearch::Backtracking> (serial));
+  size_type iterations (solver.iterations ());
+
+  // The levels are evaluated by the workers of the global scheduler, and
+  // the result does not depend on their number.
+  TaskScheduler::global ().numberWorkers (4);
+  solver.parallelEvaluation (true);
+  solver::HierarchicalIterative copy (solver);
+  BOOST_CHECK(copy.parallelEvaluation ());
+  Configuration_t parallel (qrand);
+  BOOST_CHECK_EQUAL (solver.solve<solver::lineSearch::Backtracking>
+                     (parallel), status);
+  BOOST_CHECK_EQUAL (solver.iterations (), iterations);
+  BOOST_CHECK (parallel == serial);
+  TaskScheduler::global ().numberWorkers (1);
+}
+
+BOOST_AUTO_TEST_CASE(scaling)
+{
+  // Badly scaled variables: f (x) = (1e3 x0 - 1, 1e-3 x1 - 1e-3)
+  matrix_t A (2, 2);
+  A << 1e3, 0, 0, 1e-3;
+  vector_t b (2);
+  b << -1, -1e-3;
+  solver::HierarchicalIterative solver (LiegroupSpace::Rn (2));
+  solver.maxIterations (20);
+  solver.errorThreshold (1e-12);
+  solver.add (Implicit::create (AffineFunction::create (A, b),
+                                2 * EqualToZero), 0);
+
+  vector_t x (vector_t::Zero (2));
+  BOOST_CHECK_EQUAL (solver.solve (x, solver::lineSearch::Constant ()),
+                     solver::HierarchicalIterative::SUCCESS);
+  BOOST_CHECK_CLOSE (solver.sigma (), 1e-3, 1e-6);
+
+  // The scaled Jacobian is the identity.
+  solver.automaticScaling (100);
+  x.setZero ();
+  BOOST_CHECK_EQUAL (solver.solve (x, solver::lineSearch::Constant ()),
+                     solver::HierarchicalIterative::SUCCESS);
+  BOOST_CHECK_CLOSE (solver.sigma (), 1, 1e-6);
+  EIGEN_VECTOR_IS_APPROX (x, VECTOR2 (1e-3, 1));
+}
+
+// f (x) = (x0 + 2 x1 - 3, x0 x1 - 1)
+class Bilinear : public DifferentiableFunction
+{
+public:
+  Bilinear () : DifferentiableFunction (2, 2, 2, "Bilinear") {}
+
+  void impl_compute (LiegroupElementRef y, vectorIn_t x) const
+  {
+    y.vector () << x[0] + 2 * x[1] - 3, x[0] * x[1] - 1;
+  }
+
+  void impl_jacobian (matrixOut_t J, vectorIn_t x) const
+  {
+    J << 1, 2, x[1], x[0];
+  }
+}; // class Bilinear
+
+BOOST_AUTO_TEST_CASE(scaling_reset)
+{
+  solver::HierarchicalIterative solver (LiegroupSpace::Rn (2));
+  solver.maxIterations (20);
+  solver.errorThreshold (1e-10);
+  solver.add (Implicit::create (DifferentiableFunctionPtr_t (new Bilinear),
+                                2 * EqualToZero), 0);
+  solver.automaticScaling (100);
+
+  // The scaling factors of a call do not depend on the previous calls.
+  solver::HierarchicalIterative fresh (solver);
+  vector_t x (VECTOR2 (10, -5));
+  solver.solve (x, solver::lineSearch::Backtracking ());
+  vector_t x1 (VECTOR2 (0.9, 0.6)), x2 (x1);
+  BOOST_CHECK_EQUAL (solver.solve (x1, solver::lineSearch::Backtracking ()),
+                     solver::HierarchicalIterative::SUCCESS);
+  BOOST_CHECK_EQUAL (fresh.solve (x2, solver::lineSearch::Backtracking ()),
+                     solver::HierarchicalIterative::SUCCESS);
+  BOOST_CHECK (x1 == x2);
+  BOOST_CHECK_EQUAL (solver.sigma (), fresh.sigma ());
+  BOOST_CHECK_EQUAL (solver.iterations (), fresh.iterations ());
+}
+
 BOOST_AUTO_TEST_CASE(affine_opt)
 {
   matrix_t A(1,2);
@@ -238,6 +470,26 @@ BOOST_AUTO_TEST_CASE(affine_opt)
   EIGEN_VECTOR_IS_APPROX (test.optimize(0.1,0), VECTOR2(0.5, 0.5));
   EIGEN_VECTOR_IS_APPROX (test.optimize(0,0.1), VECTOR2(0.5, 0.5));
   EIGEN_VECTOR_IS_APPROX (test.optimize(0.5, 0.5), VECTOR2(0.5, 0.5));
+
+  vector_t x0 (test.optimize(0.1,0)), x1 (test.optimize(0,0.1));
+  BOOST_CHECK_EQUAL (test.solver.reusedFactorizations (), 0);
+
+  // Reuse the decomposition of the affine constraint once it is satisfied.
+  // The result is the same as without reuse.
+  test.solver.refactorizationTolerance (1.);
+  EIGEN_VECTOR_IS_APPROX (test.optimize(0.1,0), x0);
+  BOOST_CHECK (test.solver.reusedFactorizations () > 0);
+  EIGEN_VECTOR_IS_APPROX (test.optimize(0,0.1), x1);
+  BOOST_CHECK (test.solver.reusedFactorizations () > 0);
+  EIGEN_VECTOR_IS_APPROX (test.optimize(0.5, 0.5), VECTOR2(0.5, 0.5));
+  test.solver.refactorizationTolerance (0.);
+
+  // Single precision decompositions far from the solution
+  test.solver.mixedPrecision (1e4);
+  EIGEN_VECTOR_IS_APPROX (test.optimize(0.1,0), VECTOR2(0.5, 0.5));
+  EIGEN_VECTOR_IS_APPROX (test.optimize(0,0.1), VECTOR2(0.5, 0.5));
+  EIGEN_VECTOR_IS_APPROX (test.optimize(0.5, 0.5), VECTOR2(0.5, 0.5));
+  test.solver.mixedPrecision (0);
 }
 
 // build an implicit constraint with values in SE3 and with non trivial mask
@@ -0,0 +1,210 @@
+// Copyright (c) 2026, CNRS
+//
+// This file is part of hpp-constraints.
+// hpp-constraints is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-constraints is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-constraints. If not, see <http://www.gnu.org/licenses/>.
+
+// Replay solver calls recorded by hpp::constraints::solver::Recorder.
+//
+// Usage:
+//   solver-replay generate <file>   write a corpus of calls on the
+//                                   unit-test devices,
+//   solver-replay <file> ...        replay the calls and report the
+//                                   timings and status differences.
+//
+// Records are read back with the unit-test devices of hpp-pinocchio: only
+// calls recorded with these devices can be replayed by this program.
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+
+#include <pinocchio/algorithm/joint-configuration.hpp>
+
+#include <hpp/pinocchio/device.hh>
+#include <hpp/pinocchio/joint.hh>
+#include <hpp/pinocchio/simple-device.hh>
+
+#include <hpp/constraints/generic-transformation.hh>
+#include <hpp/constraints/implicit.hh>
+#include <hpp/constraints/locked-joint.hh>
+#include <hpp/constraints/solver/by-substitution.hh>
+#include <hpp/constraints/solver/recorder.hh>
+
+using namespace hpp::constraints;
+using hpp::constraints::solver::BySubstitution;
+using hpp::constraints::solver::HierarchicalIterative;
+using hpp::constraints::solver::Recorder;
+using hpp::pinocchio::unittest::makeDevice;
+
+namespace unittest = hpp::pinocchio::unittest;
+namespace saturation = hpp::constraints::solver::saturation;
+
+// Build a unit-test device as in the tests of the solvers.
+DevicePtr_t makeCorpusDevice (unittest::TestDeviceType type)
+{
+  DevicePtr_t device (makeDevice (type));
+  if (type == unittest::HumanoidSimple || type == unittest::HumanoidRomeo) {
+    for (size_type i = 0; i < 3; ++i) {
+      device->rootJoint ()->lowerBound (i, -1);
+      device->rootJoint ()->upperBound (i,  1);
+    }
+  }
+  return device;
+}
+
+// Unit-test devices indexed by name
+class Devices
+{
+public:
+  DevicePtr_t get (const std::string& name)
+  {
+    if (devices_.empty ()) {
+      const unittest::TestDeviceType types [] = { unittest::HumanoidSimple,
+        unittest::HumanoidRomeo, unittest::ManipulatorArm2,
+        unittest::CarLike };
+      for (std::size_t i = 0; i < sizeof (types) / sizeof (types [0]); ++i) {
+        DevicePtr_t d (makeCorpusDevice (types [i]));
+        devices_ [d->name ()] = d;
+      }
+    }
+    std::map <std::string, DevicePtr_t>::const_iterator it
+      (devices_.find (name));
+    if (it == devices_.end ()) return DevicePtr_t ();
+    return it->second;
+  }
+
+private:
+  std::map <std::string, DevicePtr_t> devices_;
+};
+
+// Record calls of a BySubstitution solver constraining the feet and a hand of
+// a humanoid, and of a HierarchicalIterative solver with two priority levels.
+int generate (const char* filename)
+{
+  std::ofstream file (filename, std::ios::out | std::ios::binary);
+  if (!file) {
+    std::cerr << "Cannot open " << filename << std::endl;
+    return 1;
+  }
+  std::srand (0);
+  DevicePtr_t device (makeCorpusDevice (unittest::HumanoidSimple));
+  solver::RecorderPtr_t recorder (Recorder::create (file, device));
+
+  JointPtr_t ee1 = device->getJointByName ("rleg6_joint"),
+             ee2 = device->getJointByName ("lleg6_joint"),
+             ee3 = device->getJointByName ("larm6_joint");
+  Configuration_t q0 (device->neutralConfiguration ());
+  device->currentConfiguration (q0);
+  device->computeForwardKinematics ();
+  Transform3f tf1 (ee1->currentTransformation ());
+  Transform3f tf2 (ee2->currentTransformation ());
+  Transform3f tf3 (ee3->currentTransformation ());
+
+  BySubstitution bySubstitution (device->configSpace ());
+  bySubstitution.maxIterations (40);
+  bySubstitution.errorThreshold (1e-4);
+  bySubstitution.saturation (hpp::make_shared <saturation::Device> (device));
+  bySubstitution.add (Implicit::create (RelativeTransformation::create
+        ("RelativeTransformation", device, ee1, ee2, tf1, tf2),
+        6 * EqualToZero));
+  bySubstitution.add (Implicit::create (Transformation::create
+        ("Transformation", device, ee1, tf1), 6 * EqualToZero));
+  bySubstitution.add (Implicit::create (Orientation::create
+        ("Orientation", device, ee3, tf3), 3 * Equality));
+  bySubstitution.recorder (recorder);
+
+  HierarchicalIterative hierarchical (device->configSpace ());
+  hierarchical.maxIterations (40);
+  hierarchical.errorThreshold (1e-4);
+  hierarchical.saturation (hpp::make_shared <saturation::Device> (device));
+  hierarchical.add (Implicit::create (Transformation::create
+        ("Transformation", device, ee1, tf1), 6 * EqualToZero), 0);
+  hierarchical.add (Implicit::create (Position::create
+        ("Position", device, ee3, tf3, Transform3f::Identity ()),
+        3 * EqualToZero), 1);
+  hierarchical.recorder (recorder);
+
+  for (int i = 0; i < 20; ++i) {
+    Configuration_t q (::pinocchio::randomConfiguration (device->model ()));
+    bySubstitution.solve (q, solver::lineSearch::Backtracking ());
+    q = ::pinocchio::randomConfiguration (device->model ());
+    bySubstitution.solve (q, solver::lineSearch::ErrorNormBased ());
+    q = ::pinocchio::randomConfiguration (device->model ());
+    hierarchical.solve (q, solver::lineSearch::FixedSequence ());
+  }
+  std::cout << recorder->numberRecords () << " calls written in " << filename
+    << std::endl;
+  return 0;
+}
+
+int replay (const char* filename, Devices& devices, std::size_t& nDiff)
+{
+  std::ifstream file (filename, std::ios::in | std::ios::binary);
+  if (!file) {
+    std::cerr << "Cannot open " << filename << std::endl;
+    return 1;
+  }
+  value_type recordedTime = 0, replayedTime = 0;
+  Recorder::Record record, result;
+  std::size_t i = 0;
+  std::cout << filename << '\n' << std::setw (5) << "call"
+    << std::setw (10) << "status" << std::setw (8) << "iter"
+    << std::setw (12) << "time (ms)" << std::setw (10) << "status"
+    << std::setw (8) << "iter" << std::setw (12) << "time (ms)" << '\n';
+  while (Recorder::read (file, record)) {
+    DevicePtr_t device (devices.get (record.robotName));
+    if (!device) {
+      std::cerr << "Call " << i << ": unknown robot " << record.robotName
+        << std::endl;
+      return 1;
+    }
+    Recorder::replay (record, device, result);
+    const bool diff (result.status != record.status);
+    if (diff) ++nDiff;
+    recordedTime += record.time;
+    replayedTime += result.time;
+    std::cout << std::setw (5) << i
+      << std::setw (10) << record.status << std::setw (8) << record.iterations
+      << std::setw (12) << 1e3 * record.time
+      << std::setw (10) << result.status << std::setw (8) << result.iterations
+      << std::setw (12) << 1e3 * result.time
+      << (diff ? "  status differs" : "") << '\n';
+    ++i;
+  }
+  std::cout << "total " << i << " calls: recorded " << 1e3 * recordedTime
+    << " ms, replayed " << 1e3 * replayedTime << " ms" << std::endl;
+  return 0;
+}
+
+int main (int argc, char** argv)
+{
+  if (argc == 3 && std::strcmp (argv [1], "generate") == 0)
+    return generate (argv [2]);
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv [0] << " generate <file>\n"
+      << "       " << argv [0] << " <file> ..." << std::endl;
+    return 1;
+  }
+  Devices devices;
+  std::size_t nDiff = 0;
+  for (int i = 1; i < argc; ++i)
+    if (replay (argv [i], devices, nDiff) != 0) return 1;
+  if (nDiff > 0) {
+    std::cout << nDiff << " calls with a different status" << std::endl;
+    return 2;
+  }
+  return 0;
+}
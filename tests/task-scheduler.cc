@@ -0,0 +1,188 @@
+// Copyright (c) 2026, CNRS
+//
+// This file is part of hpp-constraints.
+// hpp-constraints is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-constraints is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-constraints. If not, see <http://www.gnu.org/licenses/>.
+
+#define BOOST_TEST_MODULE TaskScheduler
+#include <boost/test/unit_test.hpp>
+
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+#include <hpp/pinocchio/device.hh>
+#include <hpp/pinocchio/joint.hh>
+#include <hpp/pinocchio/simple-device.hh>
+
+#include <hpp/constraints/task-scheduler.hh>
+
+#include <../tests/util.hh>
+
+using hpp::constraints::TaskScheduler;
+using hpp::constraints::size_type;
+using hpp::constraints::value_type;
+using hpp::pinocchio::Configuration_t;
+using hpp::pinocchio::DevicePtr_t;
+using hpp::pinocchio::DeviceSync;
+using hpp::pinocchio::JointPtr_t;
+
+// Sum of terms of very different magnitudes: the result depends on the order
+// of the summation.
+struct Terms : TaskScheduler::Loop
+{
+  Terms (size_type n) : values (n), workers (n) {}
+  void run (size_type i, std::size_t worker)
+  {
+    values [i] = (i % 2 ? 1e16 : 1.) / (value_type) (i + 1);
+    workers [i] = worker;
+  }
+  std::vector <value_type> values;
+  std::vector <std::size_t> workers;
+};
+
+// Loop running another loop of the same scheduler from each task
+struct Nested : TaskScheduler::Loop
+{
+  Nested (TaskScheduler& s, size_type n) : scheduler (s), ok (n, 0) {}
+  void run (size_type i, std::size_t worker)
+  {
+    Terms inner (4);
+    scheduler.parallelFor (4, inner);
+    bool same = true;
+    for (std::size_t j = 0; j < inner.workers.size (); ++j)
+      same = same && (inner.workers [j] == worker);
+    ok [i] = same;
+  }
+  TaskScheduler& scheduler;
+  std::vector <int> ok;
+};
+
+// Loop changing the number of workers of its scheduler
+struct Resizing : TaskScheduler::Loop
+{
+  Resizing (TaskScheduler& s) : scheduler (s) {}
+  void run (size_type, std::size_t)
+  {
+    scheduler.numberWorkers (2);
+  }
+  TaskScheduler& scheduler;
+};
+
+struct Throwing : TaskScheduler::Loop
+{
+  void run (size_type i, std::size_t)
+  {
+    if (i == 5 || i == 17) throw std::runtime_error (i == 5 ? "5" : "17");
+  }
+};
+
+// Forward kinematics of a random configuration per task
+struct Kinematics : TaskScheduler::DeviceLoop
+{
+  Kinematics (const DevicePtr_t& r, const JointPtr_t& j,
+              const std::vector <Configuration_t>& c) :
+    robot (r), joint (j), configs (c), translations (c.size ())
+  {}
+  void run (size_type i, DeviceSync& device)
+  {
+    device.currentConfiguration (configs [i]);
+    device.computeForwardKinematics ();
+    translations [i] = joint->currentTransformation (device.d ())
+      .translation ();
+  }
+  DevicePtr_t robot;
+  JointPtr_t joint;
+  const std::vector <Configuration_t>& configs;
+  std::vector <hpp::constraints::vector3_t> translations;
+};
+
+BOOST_AUTO_TEST_CASE (deterministic)
+{
+  const size_type n = 1000;
+  value_type reference = 0;
+  for (std::size_t w = 1; w <= 4; ++w) {
+    TaskScheduler scheduler (w);
+    BOOST_CHECK_EQUAL (scheduler.numberWorkers (), w);
+    BOOST_CHECK_EQUAL (scheduler.enabled (), w > 1);
+    Terms terms (n);
+    scheduler.parallelFor (n, terms);
+    for (size_type i = 0; i < n; ++i) {
+      BOOST_CHECK (terms.workers [i] < w);
+      if (i > 0) BOOST_CHECK (terms.workers [i] >= terms.workers [i-1]);
+    }
+    value_type sum = TaskScheduler::reduce (terms.values, value_type (0),
+                                            std::plus <value_type> ());
+    if (w == 1) reference = sum;
+    // Bitwise equality
+    BOOST_CHECK_EQUAL (sum, reference);
+  }
+}
+
+BOOST_AUTO_TEST_CASE (nested)
+{
+  TaskScheduler scheduler (3);
+  Nested nested (scheduler, 12);
+  scheduler.parallelFor (12, nested);
+  for (std::size_t i = 0; i < nested.ok.size (); ++i)
+    BOOST_CHECK (nested.ok [i]);
+}
+
+BOOST_AUTO_TEST_CASE (exceptions)
+{
+  TaskScheduler scheduler (4);
+  Throwing throwing;
+  try {
+    scheduler.parallelFor (20, throwing);
+    BOOST_ERROR ("parallelFor should throw.");
+  } catch (const std::runtime_error& e) {
+    // Exception of the first chunk that failed
+    BOOST_CHECK_EQUAL (std::string (e.what ()), "5");
+  }
+  // The scheduler can still be used.
+  Terms terms (10);
+  scheduler.parallelFor (10, terms);
+  BOOST_CHECK_EQUAL (terms.values [9], 1e15);
+}
+
+BOOST_AUTO_TEST_CASE (resize_in_task)
+{
+  for (std::size_t w = 1; w <= 3; w += 2) {
+    TaskScheduler scheduler (w);
+    Resizing resizing (scheduler);
+    BOOST_CHECK_THROW (scheduler.parallelFor (6, resizing), std::logic_error);
+    BOOST_CHECK_EQUAL (scheduler.numberWorkers (), w);
+    // Outside of the tasks, the number of workers can be changed.
+    scheduler.numberWorkers (2);
+    BOOST_CHECK_EQUAL (scheduler.numberWorkers (), (std::size_t) 2);
+  }
+}
+
+BOOST_AUTO_TEST_CASE (device_data)
+{
+  DevicePtr_t device (hpp::pinocchio::unittest::makeDevice
+                      (hpp::pinocchio::unittest::HumanoidSimple));
+  BOOST_REQUIRE (device);
+  device->numberDeviceData (2);
+  JointPtr_t joint (device->getJointByName ("lleg6_joint"));
+
+  std::vector <Configuration_t> configs (40);
+  for (std::size_t i = 0; i < configs.size (); ++i)
+    randomConfig (device, configs [i]);
+
+  TaskScheduler serial (1), parallel (4);
+  Kinematics k1 (device, joint, configs), k2 (device, joint, configs);
+  serial.parallelFor ((size_type) configs.size (), k1, device);
+  parallel.parallelFor ((size_type) configs.size (), k2, device);
+  for (std::size_t i = 0; i < configs.size (); ++i)
+    BOOST_CHECK (k1.translations [i] == k2.translations [i]);
+}
@@ -20,6 +20,8 @@
 #include <hpp/pinocchio/device.hh>
 #include <hpp/pinocchio/joint.hh>
 #include <hpp/pinocchio/configuration.hh>
+#include <hpp/pinocchio/liegroup.hh>
+#include <hpp/pinocchio/liegroup-space.hh>
 #include <hpp/pinocchio/simple-device.hh>
 
 #include "hpp/constraints/generic-transformation.hh"
@@ -29,11 +31,13 @@
 #include "hpp/constraints/configuration-constraint.hh"
 #include "hpp/constraints/differentiable-function-set.hh"
 #include "hpp/constraints/tools.hh"
+#include "hpp/constraints/function/auto-diff.hh"
 
 #define BOOST_TEST_MODULE hpp_constraints
 #include <boost/test/included/unit_test.hpp>
 
 #include <stdlib.h>
+#include <ctime>
 #include <limits>
 #include <math.h>
 
@@ -229,6 +233,64 @@ BOOST_AUTO_TEST_CASE (jacobian) {
   }
 }
 
+// Value and Jacobian of ConfigurationConstraint computed over the whole
+// configuration space, as before the restriction to the weighted joints.
+void configurationConstraintReference (const LiegroupElement& goal,
+    const vector_t& weights, ConfigurationIn_t q, value_type& value,
+    matrix_t& J)
+{
+  LiegroupElementConstRef a (q, goal.space ());
+  value = .5 * weights.dot ((goal - a).cwiseAbs2 ());
+  J = (goal - a).transpose ();
+  goal.space ()->dDifference_dq0 <hpp::pinocchio::InputTimesDerivative>
+    (q, goal.vector (), J);
+  J.array () *= weights.array ().transpose ();
+}
+
+BOOST_AUTO_TEST_CASE (configurationConstraintWeights) {
+  DevicePtr_t device = createRobot ();
+  BOOST_REQUIRE (device);
+  JointPtr_t lleg5 = device->getJointByName ("lleg5_joint"),
+             lleg6 = device->getJointByName ("lleg6_joint"),
+             larm6 = device->getJointByName ("larm6_joint");
+  Configuration_t goal, q;
+  randomConfig (device, goal);
+
+  vector_t weights (vector_t::Zero (device->numberDof ()));
+  weights.head <6> ().setConstant (2);
+  weights [lleg5->rankInVelocity ()] = 1;
+  weights [lleg6->rankInVelocity ()] = 3;
+  weights [larm6->rankInVelocity ()] = .5;
+  ConfigurationConstraintPtr_t f (ConfigurationConstraint::create
+      ("Configuration", device, goal, weights));
+
+  LiegroupElement value (f->outputSpace ());
+  matrix_t J (1, device->numberDof ()), expectedJ;
+  value_type expected;
+  for (size_type i = 0; i < 10; ++i) {
+    randomConfig (device, q);
+    f->value (value, q);
+    f->jacobian (J, q);
+    configurationConstraintReference (f->goal (), weights, q, expected,
+                                      expectedJ);
+    // The operations are the same, in the same order.
+    BOOST_CHECK_EQUAL (value.vector () [0], expected);
+    BOOST_CHECK (J == expectedJ);
+  }
+
+  // Only the weighted variables appear in the Jacobian.
+  weights.head <6> ().setZero ();
+  f->weights (weights);
+  randomConfig (device, q);
+  f->value (value, q);
+  f->jacobian (J, q);
+  configurationConstraintReference (f->goal (), weights, q, expected,
+                                    expectedJ);
+  BOOST_CHECK_EQUAL (value.vector () [0], expected);
+  BOOST_CHECK (J == expectedJ);
+  BOOST_CHECK_EQUAL ((J.array () != 0).count (), 3);
+}
+
 BOOST_AUTO_TEST_CASE (SymbolicCalculus_position) {
   DevicePtr_t device = createRobot ();
   JointPtr_t ee1 = device->getJointByName ("lleg5_joint"),
@@ -310,3 +372,150 @@ BOOST_AUTO_TEST_CASE (SymbolicCalculus_jointframe) {
       BOOST_CHECK (jacobian1.isApprox ( jacobian2));
   }
 }
+
+BOOST_AUTO_TEST_CASE (SymbolicCalculus_relativeframe) {
+  DevicePtr_t device = createRobot ();
+  JointPtr_t ee1 = device->getJointByName ("lleg5_joint"),
+             ee2 = device->getJointByName ("rleg5_joint");
+  BOOST_REQUIRE (device);
+
+  /// Create the constraints
+  typedef DifferentiableFunctionPtr_t DFptr;
+  DFptr relTrans = RelativeTransformation::create ("RelTransform", device,
+                                                   ee1, ee2, MId, MId);
+  DFptr relOri = RelativeOrientation::create ("RelOrientation", device,
+                                              ee1, ee2, MId, MId);
+  DFptr ori = Orientation::create ("Orientation", device, ee2, MId);
+  DFptr relPos = RelativePosition::create ("RelPos", device, ee1, ee2,
+                                           MId, MId);
+  Traits<RelativeFrame>::Ptr_t rf = RelativeFrame::create (ee1, ee2);
+  Traits<RotationLog>::Ptr_t rl = RotationLog::create (ee2);
+  Traits<PointInJoint>::Ptr_t pij  = PointInJoint::create (ee1, vector3_t(0,0,0));
+  Traits<PointInJoint>::Ptr_t pij2 = PointInJoint::create (ee2, vector3_t(0,0,0));
+  Traits<Norm<CalculusBaseAbstract<> > >::Ptr_t dist =
+    norm (Traits<CalculusBaseAbstract<> >::Ptr_t (pij2 - pij));
+
+  Configuration_t q;
+  matrix_t J6 (6, device->numberDof ()), J3 (3, device->numberDof ());
+  for (int i = 0; i < 100; i++) {
+      randomConfig (device, q);
+      device->currentConfiguration (q);
+      device->computeForwardKinematics ();
+
+      rf->invalidate ();
+      rl->invalidate ();
+      dist->invalidate ();
+
+      // Relative frame
+      rf->computeValue (q);
+      BOOST_CHECK (rf->value ().isApprox ((*relTrans) (q).vector ()));
+      rf->computeJacobian (q);
+      J6.setZero ();
+      relTrans->jacobian (J6, q);
+      BOOST_CHECK (rf->jacobian ().isApprox (J6));
+      // Orientation part of the relative frame
+      BOOST_CHECK (rf->rotationLog ()->value ().isApprox
+                   ((*relOri) (q).vector ()));
+      J3.setZero ();
+      relOri->jacobian (J3, q);
+      BOOST_CHECK (rf->rotationLog ()->jacobian ().isApprox (J3));
+      // Orientation in world frame
+      rl->computeValue (q);
+      BOOST_CHECK (rl->value ().isApprox ((*ori) (q).vector ()));
+      rl->computeJacobian (q);
+      J3.setZero ();
+      ori->jacobian (J3, q);
+      BOOST_CHECK (rl->jacobian ().isApprox (J3));
+      // Distance between the joints
+      dist->computeValue (q);
+      BOOST_CHECK_CLOSE (dist->value () [0],
+                         (*relPos) (q).vector ().norm (), 1e-6);
+      dist->computeJacobian (q);
+      vector3_t p (pij2->value () - pij->value ());
+      matrix_t Jd ((p.transpose () / p.norm ()) *
+                   (pij2->jacobian () - pij->jacobian ()));
+      BOOST_CHECK (dist->jacobian ().isApprox (Jd));
+  }
+}
+
+// Function of the root joint configuration, written once for any scalar.
+class RootPolynomial : public function::AutoDiff <RootPolynomial>
+{
+public:
+  RootPolynomial (const DevicePtr_t& robot) :
+    function::AutoDiff <RootPolynomial> (robot->configSize (),
+                                         robot->numberDof (), 3,
+                                         "RootPolynomial", robot)
+  {}
+
+  template <typename Scalar> void compute
+  (Eigen::Matrix <Scalar, Eigen::Dynamic, 1>& y,
+   const Eigen::Matrix <Scalar, Eigen::Dynamic, 1>& q) const
+  {
+    using std::sin; using std::exp;
+    // q [3:7] is the quaternion of the root joint.
+    y [0] = q [0] * sin (q [1]) + q [3] * q [6];
+    y [1] = q [4] * q [4] - q [5] * q [2];
+    y [2] = exp (q [7]) * q [8];
+  }
+};
+
+// Function on a vector space that does not depend on its last parameter.
+class Rosenbrock : public function::AutoDiff <Rosenbrock>
+{
+public:
+  Rosenbrock () : function::AutoDiff <Rosenbrock> (4, 4, 2, "Rosenbrock")
+  {
+    activeParameters_ [3] = activeDerivativeParameters_ [3] = false;
+  }
+
+  template <typename Scalar> void compute
+  (Eigen::Matrix <Scalar, Eigen::Dynamic, 1>& y,
+   const Eigen::Matrix <Scalar, Eigen::Dynamic, 1>& x) const
+  {
+    y [0] = 10. * (x [1] - x [0] * x [0]);
+    y [1] = 1. - x [0] + x [2] * x [2];
+  }
+};
+
+BOOST_AUTO_TEST_CASE (autoDiff) {
+  const value_type eps = std::sqrt(Eigen::NumTraits<value_type>::epsilon());
+  // Vector space: compare to the exact Jacobian.
+  Rosenbrock rosenbrock;
+  vector_t x (vector_t::Random (4));
+  matrix_t J (2, 4), Jexact (matrix_t::Zero (2, 4)), fdCentral (2, 4);
+  Jexact (0, 0) = -20 * x [0]; Jexact (0, 1) = 10;
+  Jexact (1, 0) = -1; Jexact (1, 2) = 2 * x [2];
+  rosenbrock.jacobian (J, x);
+  BOOST_CHECK ((J - Jexact).cwiseAbs ().maxCoeff () < 1e-12);
+  rosenbrock.finiteDifferenceCentral (fdCentral, x);
+  checkJacobianDiffIsZero<false> (rosenbrock.name (), J - fdCentral,
+                                  sqrt (eps));
+
+  // Lie group: compare to central finite differences.
+  DevicePtr_t device = createRobot ();
+  BOOST_REQUIRE (device);
+  RootPolynomial f (device);
+  Configuration_t q;
+  J.resize (f.outputDerivativeSize (), f.inputDerivativeSize ());
+  fdCentral.resize (f.outputDerivativeSize (), f.inputDerivativeSize ());
+  for (size_t i = 0; i < NUMBER_JACOBIAN_CALCULUS; i++) {
+    randomConfig (device, q);
+    f.jacobian (J, q);
+    fdCentral.setZero (); f.finiteDifferenceCentral (fdCentral, q, device, eps);
+    checkJacobianDiffIsZero<false> (f.name (), J - fdCentral, sqrt (eps));
+  }
+
+  // Compare computation times
+  const int N = 1000;
+  std::clock_t start = std::clock ();
+  for (int i = 0; i < N; ++i) f.jacobian (J, q);
+  const double tAD ((double) (std::clock () - start) / CLOCKS_PER_SEC);
+  start = std::clock ();
+  for (int i = 0; i < N; ++i)
+    f.finiteDifferenceCentral (fdCentral, q, device, eps);
+  const double tFD ((double) (std::clock () - start) / CLOCKS_PER_SEC);
+  BOOST_TEST_MESSAGE ("Jacobian of " << f.name () << ": automatic "
+                      "differentiation " << tAD / N << "s, central finite "
+                      "differences " << tFD / N << "s.");
+}